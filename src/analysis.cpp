@@ -0,0 +1,218 @@
+/*  This file is part of LoAT.
+ *  Copyright (c) 2015-2016 Matthias Naaf, RWTH Aachen University, Germany
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses>.
+ */
+
+#include "analysis.h"
+
+#include <fstream>
+#include <cstdio>
+#include <sys/resource.h>
+
+#include "timeout.h"
+#include "stats.h"
+#include "status.h"
+#include "z3toolbox.h"
+
+using namespace std;
+
+
+/**
+ * Saves a checkpoint of the current analysis state to the given file.
+ * The checkpoint is written to a temporary file first, so the previous one is kept if we are killed while writing.
+ */
+static void saveCheckpoint(const FlowGraph &g, const string &file) {
+    string tmpFile = file + ".tmp";
+    ofstream out(tmpFile, ios::binary);
+    if (out.is_open()) {
+        g.saveCheckpoint(out);
+        out.close();
+        if (out && rename(tmpFile.c_str(),file.c_str()) == 0) return;
+    }
+    cout << "Warning: Unable to write checkpoint file: " << file << endl;
+}
+
+
+/**
+ * Records the memory usage after the last step (see Stats::MemoryInfo),
+ * only if requested as this traverses the whole graph
+ */
+static void recordMemory(const FlowGraph &g, const AnalysisSettings &settings) {
+    if (!settings.recordMemory) return;
+
+    Stats::MemoryInfo info = g.getMemoryInfo();
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF,&usage) == 0) info.peakRssKb = usage.ru_maxrss;
+    info.z3AllocBytes = Z3_get_estimated_alloc_size();
+
+    Stats::setMemory(info);
+    Status::setGraphSize(g.getNodeCount(),info.transitions);
+}
+
+
+RuntimeResult Analysis::run(ITRSProblem &itrs, const AnalysisSettings &settings, int &dotStep) {
+    ostream *dotStream = settings.dotStream;
+    FlowGraph g(itrs);
+
+    //the unsat cores of a previous analysis refer to different atoms
+    Z3Toolbox::clearUnsatCores();
+
+    proofout << endl << "Initial Control flow graph problem:" << endl;
+    g.printForProof();
+    if (dotStream) g.printDot(*dotStream,dotStep++,"Initial");
+
+    if (!settings.resumeFile.empty()) {
+        cout << "Trying to resume from checkpoint: " << settings.resumeFile << endl;
+        ifstream resumeStream(settings.resumeFile, ios::binary);
+        if (!resumeStream.is_open()) {
+            throw ITRSProblem::FileError("Unable to open file: " + settings.resumeFile);
+        }
+        try {
+            g.loadCheckpoint(resumeStream);
+        } catch (const CustomException &e) {
+            throw ITRSProblem::FileError(string("Unable to resume from checkpoint: ") + e.what());
+        }
+        proofout << endl << "Resumed from checkpoint:" << endl;
+        g.printForProof();
+        if (dotStream) g.printDot(*dotStream,dotStep++,"Resumed");
+
+    } else if (g.reduceInitialTransitions()) {
+        proofout << endl << "Removed unsatisfiable initial transitions:" << endl;
+        g.printForProof();
+        if (dotStream) g.printDot(*dotStream,dotStep++,"Reduced initial");
+    }
+
+    RuntimeResult runtime;
+    if (g.isEmpty()) return runtime;
+
+    //do some preprocessing (already done if we resume from a checkpoint)
+    if (settings.doPreprocessing && settings.resumeFile.empty()) {
+        Status::setPass("Preprocessing");
+        if (g.preprocessTransitions(settings.checkCosts)) {
+            proofout << endl <<  "Simplified the transitions:" << endl;
+            g.printForProof();
+            if (dotStream) g.printDot(*dotStream,dotStep++,"Simplify");
+        }
+    }
+
+    while (!g.isFullyChained()) {
+
+        bool changed;
+        do {
+            changed = false;
+
+            if (g.accelerateSimpleLoops()) {
+                changed = true;
+                proofout << endl <<  "Accelerated all simple loops using metering functions"
+                         << " (where possible):" << endl;
+                g.printForProof();
+                if (dotStream) g.printDot(*dotStream,dotStep++,"Accelerate simple loops");
+            }
+            recordMemory(g,settings);
+            if (Timeout::soft()) break;
+
+            if (g.chainSimpleLoops()) {
+                changed = true;
+                proofout << endl <<  "Chained simpled loops:" << endl;
+                g.printForProof();
+                if (dotStream) g.printDot(*dotStream,dotStep++,"Chain simple loops");
+            }
+            recordMemory(g,settings);
+            if (Timeout::soft()) break;
+
+            if (g.chainLinear()) {
+                changed = true;
+                proofout << endl <<  "Eliminated locations (linear):" << endl;
+                g.printForProof();
+                if (dotStream) g.printDot(*dotStream,dotStep++,"Eliminate Locations (linear)");
+            }
+            recordMemory(g,settings);
+            if (Timeout::soft()) break;
+
+        } while (changed);
+
+
+        if (g.chainBranches()) {
+            proofout << endl <<  "Eliminated locations (branches):" << endl;
+            g.printForProof();
+            if (dotStream) g.printDot(*dotStream,dotStep++,"Eliminate Locations (branches)");
+
+        } else if (g.eliminateALocation()) {
+            proofout << endl <<  "Eliminated locations:" << endl;
+            g.printForProof();
+            if (dotStream) g.printDot(*dotStream,dotStep++,"Eliminate Locations");
+        }
+        recordMemory(g,settings);
+        if (Timeout::soft()) break;
+
+        if (settings.doPruning && g.pruneTransitions()) {
+            proofout << endl <<  "Pruned:" << endl;
+            g.printForProof();
+            if (dotStream) g.printDot(*dotStream,dotStep++,"Prune");
+        }
+        recordMemory(g,settings);
+        if (Timeout::soft()) break;
+
+        if (g.skipHopelessPaths()) {
+            proofout << endl <<  "Skipped paths that cannot improve the lower bound:" << endl;
+            g.printForProof();
+            if (dotStream) g.printDot(*dotStream,dotStep++,"Skip hopeless paths");
+        }
+        recordMemory(g,settings);
+        if (Timeout::soft()) break;
+
+        if (!settings.checkpointFile.empty()) saveCheckpoint(g,settings.checkpointFile);
+    }
+
+    //the last pass might have been aborted, so save the current state as well
+    if (!settings.checkpointFile.empty()) saveCheckpoint(g,settings.checkpointFile);
+
+    if (Timeout::soft()) proofout << "Aborted due to lack of remaining time" << endl << endl;
+
+    //simplify the simplified program
+    if (g.isFullyChained()) {
+        g.removeDuplicateInitialTransitions();
+    }
+
+    proofout << endl << "Final control flow graph problem, now checking costs for infinitely many models:" << endl;
+    g.printForProof();
+    if (dotStream) g.printDot(*dotStream,dotStep++,"Final");
+
+    if (settings.printSimplified) {
+        proofout << endl << "Simplified program in input format:" << endl;
+        g.printKoAT();
+        proofout << endl;
+    }
+
+    Status::setPass("Final infinity check");
+    if (!g.isFullyChained()) {
+        //handling for timeouts
+        proofout << "This is only a partial result (probably due to a timeout), trying to find max complexity" << endl << endl;
+        runtime = g.getMaxPartialResult();
+    } else {
+        //no timeout, fully contracted, find maximum runtime
+        proofout << endl;
+        runtime = g.getMaxRuntime();
+    }
+
+    //if we failed to prove a bound, we can still output O(1) with bound 1, as the graph was non-empty
+    if (runtime.cpx == Expression::ComplexNone) {
+        runtime.cpx = 0;
+        runtime.bound = Expression(1);
+        runtime.guard.clear();
+    }
+    return runtime;
+}
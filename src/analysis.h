@@ -0,0 +1,55 @@
+/*  This file is part of LoAT.
+ *  Copyright (c) 2015-2016 Matthias Naaf, RWTH Aachen University, Germany
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses>.
+ */
+
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <ostream>
+#include <string>
+
+#include "itrs.h"
+#include "flowgraph.h"
+
+
+/**
+ * Settings for the analysis (usually specified on the command line)
+ */
+struct AnalysisSettings {
+    AnalysisSettings() : doPreprocessing(true), doPruning(true), checkCosts(true), printSimplified(false), recordMemory(false), dotStream(nullptr) {}
+    bool doPreprocessing;
+    bool doPruning; //if false, pruneTransitions is never applied
+    bool checkCosts;
+    bool printSimplified;
+    bool recordMemory; //if true, the graph size and memory usage are recorded after every step (for --stats/--status)
+    std::ostream *dotStream; //dot output is only printed if this is not null
+    std::string checkpointFile; //checkpoints are only saved if this is not empty
+    std::string resumeFile; //if not empty, the analysis continues from this checkpoint
+};
+
+
+namespace Analysis {
+    /**
+     * Runs the complete analysis for the given itrs (chaining, acceleration, pruning and the final infinity check),
+     * the proof is printed to proofout. Stops early (with a partial result) if the soft timeout is reached.
+     * @param dotStep the number of the next dot subgraph (is increased for every printed subgraph)
+     * @note throws ITRSProblem::FileError if resuming from the checkpoint fails
+     * @return the final runtime (at least constant if there are any initial transitions)
+     */
+    RuntimeResult run(ITRSProblem &itrs, const AnalysisSettings &settings, int &dotStep);
+}
+
+#endif // ANALYSIS_H
@@ -22,7 +22,7 @@ AsymptoticBound::AsymptoticBound(const ITRSProblem &its, GuardList guard,
                                  Expression cost, bool finalCheck)
     : its(its), guard(guard), cost(cost), finalCheck(finalCheck),
       addition(DirectionSize), multiplication(DirectionSize), division(DirectionSize) {
-    assert(GuardToolbox::isValidGuard(guard));
+    assertAudit(GuardToolbox::isValidGuard(guard));
 }
 
 
@@ -200,65 +200,61 @@ void AsymptoticBound::propagateBounds() {
         }
     }
 
-    // build all possible combinations of substitutions (resulting from inequalites)
+    // the combinations of substitutions (resulting from inequalities) are only built on demand,
+    // see nextCombination(), as there are exponentially many of them
+    boundBaseLP = currentLP;
+    firstBoundSubstitution = numOfEquations;
+    endBoundSubstitution = substitutions.size();
     int numOfSubstitutions = substitutions.size() - numOfEquations;
-    if (finalCheck && numOfSubstitutions <= 10) { // must be smaller than 32
-        unsigned int combination;
-        unsigned int to = (1 << numOfSubstitutions) - 1;
-
-        for (combination = 1; combination < to; combination++) {
-            limitProblems.push_back(currentLP);
-            LimitProblem &limitProblem = limitProblems.back();
-
-            debugAsymptoticBound("combination of substitutions:");
-            for (int bitPos = 0; bitPos < numOfSubstitutions; ++bitPos) {
-                if (combination & (1 << bitPos)) {
-                    debugAsymptoticBound(substitutions[numOfEquations + bitPos]);
-                }
-            }
+    unsigned int all = (1u << std::min(numOfSubstitutions, 31)) - 1;
 
-            for (int bitPos = 0; bitPos < numOfSubstitutions; ++bitPos) {
-                if (combination & (1 << bitPos)) {
-                    limitProblem.substitute(substitutions[numOfEquations + bitPos],
-                                            numOfEquations + bitPos);
-                }
-            }
-
-            if (limitProblem.isUnsolvable()) {
-                limitProblems.pop_back();
-            }
+    // pendingCombinations is a stack, so push the combinations in reverse order
+    // (i.e. they are processed as: all, none, then the remaining ones in descending order)
+    if (finalCheck && numOfSubstitutions <= 10) { // must be smaller than 32
+        for (unsigned int combination = 1; combination < all; ++combination) {
+            pendingCombinations.push_back(combination);
         }
-
     }
 
-    // no substitution (resulting from inequalies)
-    limitProblems.push_back(currentLP);
-
-    if (limitProblems.back().isUnsolvable()) {
-        limitProblems.pop_back();
+    if (numOfSubstitutions > 0) {
+        pendingCombinations.push_back(0);
     }
+    pendingCombinations.push_back(all);
+}
 
-    // all substitutions (resulting from inequalies)
-    limitProblems.push_back(currentLP);
-    LimitProblem &limitProblem = limitProblems.back();
+bool AsymptoticBound::nextCombination() {
+    while (!pendingCombinations.empty() && !Timeout::hard()) {
+        unsigned int combination = pendingCombinations.back();
+        pendingCombinations.pop_back();
+
+        LimitProblem limitProblem = boundBaseLP;
+
+        debugAsymptoticBound("combination of substitutions:");
+        for (int bitPos = 0; firstBoundSubstitution + bitPos < endBoundSubstitution; ++bitPos) {
+            // with more than 31 substitutions, only none or all of them are used
+            bool isUsed = (bitPos < 31) ? (combination & (1u << bitPos)) : (combination == (~0u >> 1));
+            if (isUsed) {
+                debugAsymptoticBound(substitutions[firstBoundSubstitution + bitPos]);
+                limitProblem.substitute(substitutions[firstBoundSubstitution + bitPos],
+                                        firstBoundSubstitution + bitPos);
+            }
+        }
 
-    debugAsymptoticBound("combination of substitutions:");
-    for (int i = numOfEquations; i < substitutions.size(); ++i) {
-        debugAsymptoticBound(substitutions[i]);
-    }
+        bool unsat;
+        if (limitProblem.isUnsolvable() || isDiscardable(limitProblem, unsat)) {
+            continue;
+        }
 
-    for (int i = numOfEquations; i < substitutions.size(); ++i) {
-        limitProblem.substitute(substitutions[i], i);
+        limitProblems.push_back(std::move(limitProblem));
+        return true;
     }
 
-    if (limitProblem.isUnsolvable()) {
-        limitProblems.pop_back();
-    }
+    return false;
 }
 
 GiNaC::exmap AsymptoticBound::calcSolution(const LimitProblem &limitProblem) {
     debugAsymptoticBound("Calculating solution for the initial limit problem.");
-    assert(limitProblem.isSolved());
+    assertAudit(limitProblem.isSolved());
 
     exmap solution;
     for (int index : limitProblem.getSubstitutions()) {
@@ -306,8 +302,8 @@ int AsymptoticBound::findUpperBoundforSolution(const LimitProblem &limitProblem,
 
         if (!its.isFreeVar(ex_to<symbol>(pair.first))) {
             Expression sub = pair.second;
-            assert(sub.is_polynomial(n));
-            assert(sub.hasNoVariables()
+            assertAudit(sub.is_polynomial(n));
+            assertAudit(sub.hasNoVariables()
                    || (sub.hasExactlyOneVariable() && sub.has(n)));
 
             Expression expanded = sub.expand();
@@ -339,10 +335,10 @@ int AsymptoticBound::findLowerBoundforSolvedCost(const LimitProblem &limitProble
     int lowerBound;
     ExprSymbol n = limitProblem.getN();
     if (solvedCost.info(info_flags::polynomial)) {
-        assert(solvedCost.is_polynomial(n));
-        assert(solvedCost.hasAtMostOneVariable());
+        assertAudit(solvedCost.is_polynomial(n));
+        assertAudit(solvedCost.hasAtMostOneVariable());
 
-        Expression expanded = solvedCost.expand();
+        Expression expanded = solvedCost.expandMemo();
         int d = expanded.degree(n);
         debugAsymptoticBound("solved cost: " << expanded << ", degree: " << d);
         lowerBound = d;
@@ -351,7 +347,7 @@ int AsymptoticBound::findLowerBoundforSolvedCost(const LimitProblem &limitProble
 
     } else {
         std::vector<Expression> nonPolynomial;
-        Expression expanded = solvedCost.expand();
+        Expression expanded = solvedCost.expandMemo();
         debugAsymptoticBound("solved cost: " << expanded);
 
         Expression powerPattern = pow(wild(1), wild(2));
@@ -384,30 +380,31 @@ int AsymptoticBound::findLowerBoundforSolvedCost(const LimitProblem &limitProble
     return lowerBound;
 }
 
-void AsymptoticBound::removeUnsatProblems() {
-    for (int i = limitProblems.size() - 1; i >= 0; --i) {
-        auto result = Z3Toolbox::checkExpressionsSAT(limitProblems[i].getQuery());
-
-        if (result == z3::unsat) {
-            debugAsymptoticBound("unsat:");
-            debugAsymptoticBound(limitProblems[i]);
-            limitProblems.erase(limitProblems.begin() + i);
-        } else if (result == z3::unknown
-                   && !finalCheck
-                   && limitProblems[i].getSize() >= LIMIT_PROBLEM_DISCARD_SIZE) {
-            debugAsymptoticBound("removing a limit problem since this is not the final check"
-                                 << " and it is very large (" << limitProblems[i].getSize()
-                                 << " InftyExpressions)");
-            limitProblems.erase(limitProblems.begin() + i);
-        }
+bool AsymptoticBound::isDiscardable(const LimitProblem &limitProblem, bool &unsat) {
+    auto result = query.check(limitProblem);
+    unsat = (result == z3::unsat);
+
+    if (unsat) {
+        debugAsymptoticBound("unsat:");
+        debugAsymptoticBound(limitProblem);
+        return true;
+
+    } else if (result == z3::unknown
+               && !finalCheck
+               && limitProblem.getSize() >= LIMIT_PROBLEM_DISCARD_SIZE) {
+        debugAsymptoticBound("removing a limit problem since this is not the final check"
+                             << " and it is very large (" << limitProblem.getSize()
+                             << " InftyExpressions)");
+        return true;
     }
+    return false;
 }
 
 
 bool AsymptoticBound::solveLimitProblem() {
     debugAsymptoticBound("Trying to solve the initial limit problem.");
 
-    if (limitProblems.empty()) {
+    if (limitProblems.empty() && !nextCombination()) {
         return false;
     }
 
@@ -503,7 +500,7 @@ bool AsymptoticBound::solveLimitProblem() {
         debugAsymptoticBound("I don't know how to continue, throwing away");
     }
 
-    if (limitProblems.empty() || Timeout::hard()) {
+    if (Timeout::hard() || (limitProblems.empty() && !nextCombination())) {
         return !solvedLimitProblems.empty();
 
     } else {
@@ -563,7 +560,7 @@ AsymptoticBound::ComplexityResult AsymptoticBound::getComplexity(const LimitProb
 
 bool AsymptoticBound::isAdequateSolution(const LimitProblem &limitProblem) {
     debugAsymptoticBound("Checking solution for adequateness.");
-    assert(limitProblem.isSolved());
+    assertAudit(limitProblem.isSolved());
 
     ComplexityResult result = getComplexity(limitProblem);
 
@@ -881,10 +878,9 @@ bool AsymptoticBound::tryInstantiatingVariable() {
         Direction dir = it->getDirection();
 
         if (it->hasExactlyOneVariable() && (dir == POS || dir == POS_CONS || dir == NEG_CONS)) {
-            Z3VariableContext context;
+            Z3VariableContext &context = query.getContext();
             z3::model model(context, Z3_model());
-            z3::check_result result;
-            result = Z3Toolbox::checkExpressionsSAT(currentLP.getQuery(), context, &model);
+            z3::check_result result = query.check(currentLP, Z3Toolbox::SiteInstantiate, &model);
 
             if (result == z3::unsat) {
                 debugAsymptoticBound("Z3: limit problem is unsat");
@@ -1072,6 +1068,18 @@ map<int, Expression> getCoefficients(Expression ex, ExprSymbol n) {
     return coefficients;
 }
 
+/**
+ * @return the coefficients of 'n' in 'poly', as for getCoefficients
+ */
+map<int, Expression> getCoefficients(const Polynomial &poly, ExprSymbol n) {
+    map<int, Expression> coefficients;
+    std::vector<Polynomial> coeffs = poly.coefficients(n);
+    for (int i = 0; i < coeffs.size(); i++) {
+        coefficients.emplace(i, coeffs[i].toExpression());
+    }
+    return coefficients;
+}
+
 bool AsymptoticBound::trySmtEncoding() {
     debugAsymptoticBound(endl << "SMT: " << currentLP << endl);
 
@@ -1080,9 +1088,6 @@ bool AsymptoticBound::trySmtEncoding() {
 
     // initialize z3
     Z3Solver solver(context);
-    z3::params params(context);
-    params.set(":timeout", Z3_LIMITSMT_TIMEOUT);
-    solver.set(params);
 
     // the parameter of the desired family of solutions
     ExprSymbol n = currentLP.getN();
@@ -1092,6 +1097,7 @@ bool AsymptoticBound::trySmtEncoding() {
 
     // create linear templates for all variables
     exmap templateSubs;
+    Polynomial::Substitution templatePolys;
     map<ExprSymbol,z3::expr,GiNaC::ex_is_less> varCoeff, varCoeff0;
     for (const ExprSymbol &var : vars) {
         ExprSymbol c0 = its.getFreshSymbol(var.get_name()+"_0");
@@ -1099,15 +1105,20 @@ bool AsymptoticBound::trySmtEncoding() {
         varCoeff.emplace(var,Expression::ginacToZ3(c,context)); //HACKy HACK
         varCoeff0.emplace(var,Expression::ginacToZ3(c0,context));
         templateSubs[var] = c0 + (n * c);
+        templatePolys[var] = Polynomial(c0) + Polynomial(n) * Polynomial(c);
     }
 
     // replace variables in the cost function with their linear templates
-    Expression templateCost = cost.subs(templateSubs).expand();
+    map<int, Expression> costCoefficients;
+    Polynomial costPoly;
+    if (Polynomial::fromExpression(cost, costPoly)) {
+        costCoefficients = getCoefficients(costPoly.substitute(templatePolys), n);
+    } else {
+        costCoefficients = getCoefficients(Expression(cost.subs(templateSubs)).expandMemo(), n);
+    }
+    int maxDeg = costCoefficients.rbegin()->first;
 
     // if the cost function is a constant, then we are bound to fail
-    GiNaC::lst nList;
-    nList.append(n);
-    int maxDeg = templateCost.getMaxDegree(nList);
     if (maxDeg == 0) {
         return false;
     }
@@ -1115,8 +1126,13 @@ bool AsymptoticBound::trySmtEncoding() {
     // encode every entry of the limit problem
     for (it = currentLP.cbegin(); it != currentLP.cend(); ++it) {
         // replace variables with their linear templates
-        Expression ex = (*it).subs(templateSubs).expand();
-        map<int, Expression> coefficients = getCoefficients(ex, n);
+        map<int, Expression> coefficients;
+        const Polynomial *poly = it->getPolynomial();
+        if (poly) {
+            coefficients = getCoefficients(poly->substitute(templatePolys), n);
+        } else {
+            coefficients = getCoefficients((*it).subs(templateSubs).expand(), n);
+        }
         Direction direction = it->getDirection();
         // add the required constraints (depending on the direction-label from the limit problem)
         if (direction == POS) {
@@ -1136,7 +1152,7 @@ bool AsymptoticBound::trySmtEncoding() {
     // auxiliary function that checks satisfiability wrt. the current state of the solver
     auto checkSolver = [&]() -> bool {
         debugAsymptoticBound("SMT Query: " << solver);
-        z3::check_result res = solver.check();
+        z3::check_result res = Z3Toolbox::check(solver,Z3Toolbox::SiteLimitSmt);
         debugAsymptoticBound("SMT Result: " << res);
         if (res == z3::sat) {
             return true;
@@ -1165,9 +1181,8 @@ bool AsymptoticBound::trySmtEncoding() {
         // we failed to find a model -- drop all non-mandatory constraints
         solver.pop();
         // try to find a witness for polynomial complexity with degree maxDeg,...,1
-        map<int, Expression> coefficients = getCoefficients(templateCost, n);
         for (int i = maxDeg; i > 0; i--) {
-            Expression c = coefficients.find(i)->second;
+            Expression c = costCoefficients.find(i)->second;
             // remember the current state for backtracking
             solver.push();
             solver.add(c.toZ3(context) > 0);
@@ -1213,10 +1228,10 @@ InfiniteInstances::Result AsymptoticBound::determineComplexity(const ITRSProblem
         debugAsymptoticBound(ex);
     }
     debugAsymptoticBound("");
-    debugAsymptoticBound("cost:" << cost.expand());
+    debugAsymptoticBound("cost:" << cost.expandMemo());
     debugAsymptoticBound("");
 
-    Expression expandedCost = cost.expand();
+    Expression expandedCost = cost.expandMemo();
     //if cost contains infty, check if coefficient > 0 is SAT, otherwise remove infty symbol
     if (expandedCost.has(Expression::Infty)) {
         Expression inftyCoeff = expandedCost.coeff(Expression::Infty);
@@ -1240,7 +1255,6 @@ InfiniteInstances::Result AsymptoticBound::determineComplexity(const ITRSProblem
     //otherwise perform limit calculus
     asymptoticBound.createInitialLimitProblem();
     asymptoticBound.propagateBounds();
-    asymptoticBound.removeUnsatProblems();
     if (asymptoticBound.solveLimitProblem()) {
         debugAsymptoticBound("Solved the initial limit problem. ("
                 << asymptoticBound.solvedLimitProblems.size()
@@ -1254,7 +1268,7 @@ InfiniteInstances::Result AsymptoticBound::determineComplexity(const ITRSProblem
         Expression solvedCost = asymptoticBound.cost.subs(asymptoticBound.bestComplexity.solution);
         return InfiniteInstances::Result(asymptoticBound.bestComplexity.complexity,
                 asymptoticBound.bestComplexity.upperBound > 1,
-                solvedCost.expand(),
+                solvedCost.expandMemo(),
                 asymptoticBound.bestComplexity.inftyVars,
                 "Solved the initial limit problem");
     } else {
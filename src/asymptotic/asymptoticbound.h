@@ -8,6 +8,7 @@
 #include "guardtoolbox.h"
 #include "infinity.h"
 #include "itrs.h"
+#include "incrementalquery.h"
 #include "inftyexpression.h"
 #include "limitproblem.h"
 
@@ -35,10 +36,18 @@ private:
     void normalizeGuard();
     void createInitialLimitProblem();
     void propagateBounds();
+
+    /**
+     * Pushes the limit problem for the next combination of substitutions (resulting from inequalities)
+     * that is neither unsolvable nor discardable (see isDiscardable).
+     * @return false if there is no such combination left
+     */
+    bool nextCombination();
+
     GiNaC::exmap calcSolution(const LimitProblem &limitProblem);
     int findUpperBoundforSolution(const LimitProblem &limitProblem, const GiNaC::exmap &solution);
     int findLowerBoundforSolvedCost(const LimitProblem &limitProblem, const GiNaC::exmap &solution);
-    void removeUnsatProblems();
+    bool isDiscardable(const LimitProblem &limitProblem, bool &unsat);
     bool solveLimitProblem();
     ComplexityResult getComplexity(const LimitProblem &limitProblem);
     bool isAdequateSolution(const LimitProblem &limitProblem);
@@ -80,8 +89,17 @@ private:
     std::vector<LimitProblem> solvedLimitProblems;
     LimitProblem currentLP;
 
+    //shared by all SAT checks of limit problems during the search
+    IncrementalQuery query;
+
     std::vector<GiNaC::exmap> substitutions;
 
+    //lazily enumerated combinations of substitutions (resulting from inequalities), as bitmasks
+    LimitProblem boundBaseLP;
+    int firstBoundSubstitution = 0;
+    int endBoundSubstitution = 0;
+    std::vector<unsigned int> pendingCombinations;
+
     std::vector<LimitVector> toApply;
 
 public:
@@ -0,0 +1,47 @@
+#include "incrementalquery.h"
+
+#include <string>
+
+#include "debug.h"
+
+IncrementalQuery::IncrementalQuery()
+    : solver(context), literalCount(0) {
+}
+
+
+z3::check_result IncrementalQuery::check(const LimitProblem &limitProblem, Z3Toolbox::CallSite site,
+                                         z3::model *model) {
+    z3::expr_vector assumptions(context);
+    for (auto it = limitProblem.cbegin(); it != limitProblem.cend(); ++it) {
+        assumptions.push_back(getLiteral(*it));
+    }
+
+    z3::check_result res = Z3Toolbox::check(solver, site, &assumptions);
+    debugZ3(solver, res, "IncrementalQuery");
+
+    if (res == z3::sat && model) {
+        *model = solver.get_model();
+    }
+    return res;
+}
+
+
+z3::expr IncrementalQuery::getLiteral(const InftyExpression &ex) {
+    bool negative = (ex.getDirection() == NEG_INF || ex.getDirection() == NEG_CONS);
+    auto &map = literals[negative ? 1 : 0];
+
+    auto it = map.find(ex);
+    if (it != map.end()) {
+        return it->second;
+    }
+
+    // same constraint as in LimitProblem::getQuery()
+    Expression expanded = ex.expandMemo();
+    Expression constraint = negative ? (expanded < 0) : (expanded > 0);
+
+    z3::expr lit = context.bool_const(("__lp_" + std::to_string(literalCount++)).c_str());
+    solver.add(z3::implies(lit, constraint.toZ3(context)));
+
+    map.emplace(ex, lit);
+    return lit;
+}
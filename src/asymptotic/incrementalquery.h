@@ -0,0 +1,47 @@
+#ifndef INCREMENTALQUERY_H
+#define INCREMENTALQUERY_H
+
+#include <map>
+#include <ginac/ginac.h>
+#include <z3++.h>
+
+#include "inftyexpression.h"
+#include "limitproblem.h"
+#include "z3toolbox.h"
+
+/**
+ * Incremental z3 solver for the queries of the limit problems of one search (see LimitProblem::getQuery()).
+ * Consecutive limit problems only differ in a few InftyExpressions, so every InftyExpression is translated
+ * and asserted only once, guarded by its own literal. A limit problem is then checked under the literals
+ * of its InftyExpressions, so constraints that are no longer part of the problem are retracted for free.
+ */
+class IncrementalQuery {
+public:
+    IncrementalQuery();
+
+    /**
+     * Checks if the query of the given limit problem is satisfiable
+     * @param model if given and the result is sat, set to a model (belonging to getContext())
+     */
+    z3::check_result check(const LimitProblem &limitProblem, Z3Toolbox::CallSite site = Z3Toolbox::SiteDefault,
+                           z3::model *model = nullptr);
+
+    /**
+     * The context all InftyExpressions are translated in, e.g. to read out variables of a model
+     */
+    Z3VariableContext& getContext() { return context; }
+
+private:
+    //returns the literal guarding the constraint of the given InftyExpression (asserts it if it is new)
+    z3::expr getLiteral(const InftyExpression &ex);
+
+private:
+    Z3VariableContext context;
+    Z3Solver solver;
+
+    //literals of all asserted constraints, for positive (ex > 0) and negative (ex < 0) directions
+    std::map<GiNaC::ex, z3::expr, GiNaC::ex_is_less> literals[2];
+    int literalCount;
+};
+
+#endif //INCREMENTALQUERY_H
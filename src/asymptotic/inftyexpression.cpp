@@ -53,6 +53,18 @@ bool InftyExpression::isTriviallyUnsatisfiable() const {
     return false;
 }
 
+const Polynomial* InftyExpression::getPolynomial() const {
+    if (!polynomialComputed) {
+        Polynomial poly;
+        if (Polynomial::fromExpression(*this, poly)) {
+            polynomial = std::make_shared<const Polynomial>(std::move(poly));
+        }
+        polynomialComputed = true;
+    }
+    return polynomial.get();
+}
+
+
 std::ostream& operator<<(std::ostream &os, const InftyExpression &ie) {
     os << static_cast<const Expression &>(ie) << " ("
        << DirectionNames[ie.getDirection()] << ")";
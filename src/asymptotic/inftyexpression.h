@@ -1,9 +1,11 @@
 #ifndef INFTYEXPRESSION_H
 #define INFTYEXPRESSION_H
 
+#include <memory>
 #include <set>
 
 #include "expression.h"
+#include "polynomial.h"
 
 /**
  * This enum represents a direction. POS stands for POS_INF or POS_CONS.
@@ -48,9 +50,18 @@ public:
      */
     bool isTriviallyUnsatisfiable() const;
 
+    /**
+     * Returns this expression as Polynomial, or nullptr if it is not polynomial.
+     * The conversion is only done once and shared by all copies of this InftyExpression.
+     */
+    const Polynomial* getPolynomial() const;
+
 private:
     Direction direction;
 
+    mutable std::shared_ptr<const Polynomial> polynomial;
+    mutable bool polynomialComputed = false;
+
 };
 
 std::ostream& operator<<(std::ostream &os, const InftyExpression &ie);
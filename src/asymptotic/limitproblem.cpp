@@ -17,7 +17,7 @@ LimitProblem::LimitProblem()
 LimitProblem::LimitProblem(const GuardList &normalizedGuard, const Expression &cost)
     : variableN("n"), unsolvable(false), log(new std::ostringstream()) {
     for (const Expression &ex : normalizedGuard) {
-        assert(GuardToolbox::isNormalizedInequality(ex));
+        assertAudit(GuardToolbox::isNormalizedInequality(ex));
 
         addExpression(InftyExpression(ex.lhs(), POS));
     }
@@ -33,7 +33,7 @@ LimitProblem::LimitProblem(const GuardList &normalizedGuard, const Expression &c
 LimitProblem::LimitProblem(const GuardList &normalizedGuard)
     : variableN("n"), unsolvable(false), log(new std::ostringstream()) {
     for (const Expression &ex : normalizedGuard) {
-        assert(GuardToolbox::isNormalizedInequality(ex));
+        assertAudit(GuardToolbox::isNormalizedInequality(ex));
         addExpression(InftyExpression(ex.lhs(), POS));
     }
 
@@ -47,7 +47,11 @@ LimitProblem::LimitProblem(const LimitProblem &other)
       variableN(other.variableN),
       substitutions(other.substitutions),
       log(new std::ostringstream()),
-      unsolvable(other.unsolvable) {
+      unsolvable(other.unsolvable),
+      nonSymbolCount(other.nonSymbolCount),
+      nonPolynomialCount(other.nonPolynomialCount),
+      nonLinearCount(other.nonLinearCount),
+      variableCount(other.variableCount) {
     (*log) << other.log->str();
 }
 
@@ -59,6 +63,10 @@ LimitProblem& LimitProblem::operator=(const LimitProblem &other) {
         substitutions = other.substitutions;
         (*log) << other.log->str();
         unsolvable = other.unsolvable;
+        nonSymbolCount = other.nonSymbolCount;
+        nonPolynomialCount = other.nonPolynomialCount;
+        nonLinearCount = other.nonLinearCount;
+        variableCount = other.variableCount;
     }
 
     return *this;
@@ -70,7 +78,11 @@ LimitProblem::LimitProblem(LimitProblem &&other)
       variableN(other.variableN),
       substitutions(std::move(other.substitutions)),
       log(std::move(other.log)),
-      unsolvable(other.unsolvable) {
+      unsolvable(other.unsolvable),
+      nonSymbolCount(other.nonSymbolCount),
+      nonPolynomialCount(other.nonPolynomialCount),
+      nonLinearCount(other.nonLinearCount),
+      variableCount(std::move(other.variableCount)) {
 }
 
 
@@ -81,6 +93,10 @@ LimitProblem& LimitProblem::operator=(LimitProblem &&other) {
         substitutions = std::move(other.substitutions);
         log = std::move(other.log);
         unsolvable = other.unsolvable;
+        nonSymbolCount = other.nonSymbolCount;
+        nonPolynomialCount = other.nonPolynomialCount;
+        nonLinearCount = other.nonLinearCount;
+        variableCount = std::move(other.variableCount);
     }
 
     return *this;
@@ -92,14 +108,14 @@ void LimitProblem::addExpression(const InftyExpression &ex) {
 
     if (it == set.end()) {
         // ex is not present
-        set.insert(ex);
+        insert(ex);
 
     } else {
         // ex is already present
         if (it->getDirection() != ex.getDirection()) {
             if (it->getDirection() == POS &&
                 (ex.getDirection() == POS_INF || ex.getDirection() == POS_CONS)) {
-                // fix direction
+                // fix direction (the properties only depend on the expression, not on the direction)
                 set.erase(it);
                 set.insert(ex);
 
@@ -118,6 +134,52 @@ void LimitProblem::addExpression(const InftyExpression &ex) {
 }
 
 
+void LimitProblem::insert(const InftyExpression &ex) {
+    // update first, so the copy in set shares the polynomial computed for ex
+    updateProperties(ex, 1);
+    set.insert(ex);
+}
+
+
+void LimitProblem::erase(const InftyExpressionSet::const_iterator &it) {
+    updateProperties(*it, -1);
+    set.erase(it);
+}
+
+
+void LimitProblem::clearProperties() {
+    nonSymbolCount = 0;
+    nonPolynomialCount = 0;
+    nonLinearCount = 0;
+    variableCount.clear();
+}
+
+
+void LimitProblem::updateProperties(const InftyExpression &ex, int delta) {
+    if (!is_a<symbol>(ex)) {
+        nonSymbolCount += delta;
+    }
+
+    ExprSymbolSet vars = ex.getVariables();
+    for (const ExprSymbol &var : vars) {
+        int &count = variableCount[var];
+        count += delta;
+        if (count == 0) {
+            variableCount.erase(var);
+        }
+    }
+
+    // being polynomial (linear) in the own variables implies being polynomial (linear) in any set of variables
+    const Polynomial *poly = ex.getPolynomial();
+    if (poly == nullptr) {
+        nonPolynomialCount += delta;
+        nonLinearCount += delta;
+    } else if (poly->totalDegree() > 1) {
+        nonLinearCount += delta;
+    }
+}
+
+
 InftyExpressionSet::iterator LimitProblem::cbegin() const {
     return set.cbegin();
 }
@@ -143,7 +205,7 @@ void LimitProblem::applyLimitVector(const InftyExpressionSet::const_iterator &it
                       << " by " << firstIE << " and " << secondIE << " using " << lv);
 
 
-    set.erase(it);
+    erase(it);
     addExpression(firstIE);
     addExpression(secondIE);
 
@@ -165,7 +227,7 @@ void LimitProblem::removeConstant(const InftyExpressionSet::const_iterator &it)
     (*log) << "applying transformation rule (B), deleting " << *it << std::endl;
     debugLimitProblem("applying transformation rule (B), deleting " << *it);
 
-    set.erase(it);
+    erase(it);
 
     (*log) << "resulting limit problem:" << std::endl << *this << std::endl << std::endl;
     debugLimitProblem("resulting limit problem:");
@@ -176,7 +238,7 @@ void LimitProblem::removeConstant(const InftyExpressionSet::const_iterator &it)
 
 void LimitProblem::substitute(const GiNaC::exmap &sub, int substitutionIndex) {
     for (auto const &s : sub) {
-        assert(!s.second.has(s.first));
+        assertAudit(!s.second.has(s.first));
     }
 
     (*log) << "applying transformation rule (C) using substitution " << sub << std::endl;
@@ -184,6 +246,7 @@ void LimitProblem::substitute(const GiNaC::exmap &sub, int substitutionIndex) {
 
     InftyExpressionSet oldSet;
     oldSet.swap(set);
+    clearProperties();
     for (const InftyExpression &ex : oldSet) {
         addExpression(InftyExpression(ex.subs(sub), ex.getDirection()));
     }
@@ -198,22 +261,35 @@ void LimitProblem::substitute(const GiNaC::exmap &sub, int substitutionIndex) {
 
 
 void LimitProblem::trimPolynomial(const InftyExpressionSet::const_iterator &it) {
-    // the expression has to be a univariate polynomial
-    assert(it->info(info_flags::polynomial));
-    assert(it->hasExactlyOneVariable());
-
     Direction dir = it->getDirection();
     assert((dir == POS) || (dir == POS_INF) || (dir == NEG_INF));
 
-    ExprSymbol var = it->getAVariable();
-
-    Expression expanded = it->expand();
-    debugLimitProblem("expanded " << *it << " to " << expanded);
+    // the expression has to be a univariate polynomial
+    bool isMonom;
+    Expression leadingTerm;
+    const Polynomial *poly = it->getPolynomial();
+    if (poly != nullptr) {
+        assert(poly->getVariables().size() == 1);
+        isMonom = poly->getTermCount() <= 1;
+        if (!isMonom) {
+            leadingTerm = poly->leadingTerm(poly->getVariables().front()).toExpression();
+        }
+    } else {
+        // not supported by the sparse kernel (e.g. large exponents)
+        assertAudit(it->info(info_flags::polynomial));
+        assertAudit(it->hasExactlyOneVariable());
+        ExprSymbol var = it->getAVariable();
 
+        Expression expanded = it->expandMemo();
+        debugLimitProblem("expanded " << *it << " to " << expanded);
 
-    if (is_a<add>(expanded)) {
-        Expression leadingTerm = expanded.lcoeff(var) * pow(var, expanded.degree(var));
+        isMonom = !is_a<add>(expanded);
+        if (!isMonom) {
+            leadingTerm = expanded.lcoeff(var) * pow(var, expanded.degree(var));
+        }
+    }
 
+    if (!isMonom) {
         debugLimitProblem("the leading term is " << leadingTerm);
 
         if (dir == POS) {
@@ -228,7 +304,7 @@ void LimitProblem::trimPolynomial(const InftyExpressionSet::const_iterator &it)
         debugLimitProblem("applying transformation rule (D), replacing " << *it
                           << " by " << inftyExp);
 
-        set.erase(it);
+        erase(it);
         addExpression(inftyExp);
     } else {
         debugLimitProblem(*it << " is already a monom");
@@ -246,7 +322,7 @@ void LimitProblem::reduceExp(const InftyExpressionSet::const_iterator &it) {
 
     debugLimitProblem("expression: " << *it);
 
-    assert(it->hasExactlyOneVariable());
+    assertAudit(it->hasExactlyOneVariable());
     ExprSymbol x = it->getAVariable();
 
     Expression powerInExp;
@@ -267,16 +343,16 @@ void LimitProblem::reduceExp(const InftyExpressionSet::const_iterator &it) {
 
     Expression b = *it - powerInExp;
     debugLimitProblem("b: " << b);
-    assert(b.is_polynomial(x));
+    assertAudit(b.is_polynomial(x));
 
     Expression a = powerInExp.op(0);
     Expression e = powerInExp.op(1);
 
     debugLimitProblem("a: " << a << ", e: " << e);
 
-    assert(a.is_polynomial(x));
-    assert(e.is_polynomial(x));
-    assert(e.has(x));
+    assertAudit(a.is_polynomial(x));
+    assertAudit(e.is_polynomial(x));
+    assertAudit(e.has(x));
 
     InftyExpression firstIE(a - 1, POS);
     InftyExpression secondIE(e, POS_INF);
@@ -286,7 +362,7 @@ void LimitProblem::reduceExp(const InftyExpressionSet::const_iterator &it) {
     debugLimitProblem("applying transformation rule (E), replacing " << *it
                       << " by " << firstIE << " and " << secondIE);
 
-    set.erase(it);
+    erase(it);
     addExpression(firstIE);
     addExpression(secondIE);
 
@@ -318,7 +394,7 @@ void LimitProblem::reduceGeneralExp(const InftyExpressionSet::const_iterator &it
     }
     debugLimitProblem("general power: " << powerInExp);
     assert(is_a<power>(powerInExp));
-    assert(!powerInExp.op(1).info(info_flags::polynomial)
+    assertAudit(!powerInExp.op(1).info(info_flags::polynomial)
            || powerInExp.hasAtLeastTwoVariables());
 
     Expression b = *it - powerInExp;
@@ -337,7 +413,7 @@ void LimitProblem::reduceGeneralExp(const InftyExpressionSet::const_iterator &it
     debugLimitProblem("reducing general power, replacing " << *it
                       << " by " << firstIE << " and " << secondIE);
 
-    set.erase(it);
+    erase(it);
     addExpression(firstIE);
     addExpression(secondIE);
 
@@ -351,6 +427,7 @@ void LimitProblem::reduceGeneralExp(const InftyExpressionSet::const_iterator &it
 void LimitProblem::removeAllConstraints() {
     (*log) << "removing all constraints (solved by SMT)" << std::endl;
     set.clear();
+    clearProperties();
     (*log) << "resulting limit problem: " << *this << std::endl << std::endl;
 }
 
@@ -370,10 +447,8 @@ bool LimitProblem::isSolved() const {
     }
 
     // Check if an expression is not a variable
-    for (const InftyExpression &ex : set) {
-        if (!is_a<symbol>(ex)) {
-            return false;
-        }
+    if (nonSymbolCount > 0) {
+        return false;
     }
 
     // Since the infinity expressions are compared using GiNaC::ex_is_less,
@@ -384,7 +459,7 @@ bool LimitProblem::isSolved() const {
 
 
 GiNaC::exmap LimitProblem::getSolution() const {
-    assert(isSolved());
+    assertAudit(isSolved());
 
     exmap solution;
     for (const InftyExpression &ex : set) {
@@ -426,9 +501,8 @@ InftyExpressionSet::const_iterator LimitProblem::find(const InftyExpression &ex)
 
 ExprSymbolSet LimitProblem::getVariables() const {
     ExprSymbolSet res;
-    for (const InftyExpression &ex : set) {
-        ExprSymbolSet exVars = ex.getVariables();
-        res.insert(exVars.cbegin(),exVars.cend());
+    for (const auto &pair : variableCount) {
+        res.insert(res.end(), pair.first);
     }
     return res;
 }
@@ -439,9 +513,9 @@ std::vector<Expression> LimitProblem::getQuery() const {
 
     for (const InftyExpression &ex : set) {
         if (ex.getDirection() == NEG_INF || ex.getDirection() == NEG_CONS) {
-            query.push_back(ex.expand() < 0);
+            query.push_back(ex.expandMemo() < 0);
         } else {
-            query.push_back(ex.expand() > 0);
+            query.push_back(ex.expandMemo() > 0);
         }
     }
 
@@ -455,6 +529,11 @@ bool LimitProblem::isUnsat() const {
 
 
 bool LimitProblem::isLinear(const GiNaC::lst &vars) const {
+    if (nonLinearCount == 0) {
+        return true;
+    }
+
+    // some expression is nonlinear in its own variables, but maybe not in the given ones
     for (const InftyExpression &ex : set) {
         if (!ex.isLinear(vars)) {
             return false;
@@ -464,6 +543,11 @@ bool LimitProblem::isLinear(const GiNaC::lst &vars) const {
 }
 
 bool LimitProblem::isPolynomial(const GiNaC::lst &vars) const {
+    if (nonPolynomialCount == 0) {
+        return true;
+    }
+
+    // some expression is not polynomial in its own variables, but maybe in the given ones
     for (const InftyExpression &ex : set) {
         if (!ex.is_polynomial(vars)) {
             return false;
@@ -491,16 +575,16 @@ bool LimitProblem::trimPolynomialIsApplicable(const InftyExpressionSet::const_it
         return false;
     }
 
-    if (!it->info(info_flags::polynomial)) {
-        return false;
-    }
-
-    // Check if it is a monom
-    if (!is_a<add>(it->expand())) {
-        return false;
+    // the expression has to be a univariate polynomial, but not a monom
+    const Polynomial *poly = it->getPolynomial();
+    if (poly != nullptr) {
+        return poly->getVariables().size() == 1 && poly->getTermCount() > 1;
     }
 
-    return it->hasExactlyOneVariable();
+    // not supported by the sparse kernel (e.g. large exponents), so check it with GiNaC
+    return it->info(info_flags::polynomial)
+           && it->hasExactlyOneVariable()
+           && is_a<add>(it->expandMemo());
 }
 
 
@@ -1,6 +1,7 @@
 #ifndef LIMITPROBLEM_H
 #define LIMITPROBLEM_H
 
+#include <map>
 #include <ostream>
 #include <set>
 #include <sstream>
@@ -220,12 +221,28 @@ public:
      */
     std::string getProof() const;
 
+private:
+    /**
+     * Inserts/erases an InftyExpression and updates the maintained properties accordingly.
+     * All modifications of set must use these methods, clearing set requires clearProperties().
+     */
+    void insert(const InftyExpression &ex);
+    void erase(const InftyExpressionSet::const_iterator &it);
+    void updateProperties(const InftyExpression &ex, int delta);
+    void clearProperties();
+
 private:
     InftyExpressionSet set;
     ExprSymbol variableN;
     std::vector<int> substitutions;
     std::unique_ptr<std::ostringstream> log; //use unique_ptr, as gcc < 5 is lacking std::move on ostringstream
     bool unsolvable;
+
+    //properties of set, maintained incrementally by insert and erase
+    int nonSymbolCount = 0;
+    int nonPolynomialCount = 0; //number of expressions that are not polynomial in their variables
+    int nonLinearCount = 0; //number of expressions that are not linear in their variables
+    std::map<ExprSymbol, int, GiNaC::ex_is_less> variableCount; //number of expressions containing a variable
 };
 
 std::ostream& operator<<(std::ostream &os, const LimitProblem &lp);
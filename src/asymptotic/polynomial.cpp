@@ -0,0 +1,285 @@
+#include "polynomial.h"
+
+#include <algorithm>
+
+#include "debug.h"
+#include "global.h"
+
+using namespace GiNaC;
+
+
+Polynomial::Polynomial(const numeric &c) {
+    if (!c.is_zero()) {
+        terms.push_back(Term{std::vector<int>(), c, 0});
+    }
+}
+
+
+Polynomial::Polynomial(const ExprSymbol &var) {
+    vars.push_back(var);
+    terms.push_back(Term{std::vector<int>(1, 1), numeric(1), 1});
+}
+
+
+bool Polynomial::fromExpression(const ex &e, Polynomial &res) {
+    if (is_a<numeric>(e)) {
+        const numeric &num = ex_to<numeric>(e);
+        if (!num.is_rational()) return false;
+        res = Polynomial(num);
+        return true;
+
+    } else if (is_a<symbol>(e)) {
+        res = Polynomial(ex_to<symbol>(e));
+        return true;
+
+    } else if (is_a<add>(e) || is_a<mul>(e)) {
+        bool isAdd = is_a<add>(e);
+        Polynomial acc = isAdd ? Polynomial() : Polynomial(numeric(1));
+        for (size_t i = 0; i < e.nops(); ++i) {
+            Polynomial op;
+            if (!fromExpression(e.op(i), op)) return false;
+            acc = isAdd ? (acc + op) : (acc * op);
+        }
+        res = std::move(acc);
+        return true;
+
+    } else if (is_a<power>(e)) {
+        if (!is_a<numeric>(e.op(1))) return false;
+        const numeric &exp = ex_to<numeric>(e.op(1));
+        if (!exp.is_nonneg_integer() || exp > POLYNOMIAL_MAX_EXPONENT) return false;
+
+        Polynomial base;
+        if (!fromExpression(e.op(0), base)) return false;
+        res = base.pow(exp.to_int());
+        return true;
+    }
+
+    return false;
+}
+
+
+Expression Polynomial::toExpression() const {
+    ex res = 0;
+    for (const Term &term : terms) {
+        ex monomial = term.coeff;
+        for (int i = 0; i < vars.size(); ++i) {
+            if (term.exps[i] > 0) {
+                monomial = monomial * GiNaC::pow(vars[i], term.exps[i]);
+            }
+        }
+        res = res + monomial;
+    }
+    return res;
+}
+
+
+int Polynomial::indexOf(const ExprSymbol &var) const {
+    auto it = std::lower_bound(vars.begin(), vars.end(), var, ex_is_less());
+    if (it == vars.end() || ex_is_less()(var, *it)) {
+        return -1;
+    }
+    return it - vars.begin();
+}
+
+
+int Polynomial::degree(const ExprSymbol &var) const {
+    int idx = indexOf(var);
+    if (idx < 0) return 0;
+
+    int res = 0;
+    for (const Term &term : terms) {
+        res = std::max(res, term.exps[idx]);
+    }
+    return res;
+}
+
+
+int Polynomial::totalDegree() const {
+    // the terms are sorted by descending degree
+    return terms.empty() ? 0 : terms.front().degree;
+}
+
+
+Polynomial Polynomial::leadingTerm(const ExprSymbol &var) const {
+    int idx = indexOf(var);
+    if (idx < 0) return *this;
+
+    int deg = degree(var);
+    Polynomial res;
+    res.vars = vars;
+    for (const Term &term : terms) {
+        if (term.exps[idx] == deg) {
+            res.terms.push_back(term);
+        }
+    }
+    res.normalize();
+    return res;
+}
+
+
+std::vector<Polynomial> Polynomial::coefficients(const ExprSymbol &var) const {
+    int idx = indexOf(var);
+    if (idx < 0) return {*this};
+
+    std::vector<Polynomial> res(degree(var) + 1);
+    for (Polynomial &coeff : res) {
+        coeff.vars = vars;
+    }
+    for (const Term &term : terms) {
+        Term coeffTerm = term;
+        coeffTerm.exps[idx] = 0;
+        coeffTerm.degree -= term.exps[idx];
+        res[term.exps[idx]].terms.push_back(std::move(coeffTerm));
+    }
+    for (Polynomial &coeff : res) {
+        coeff.normalize();
+    }
+    return res;
+}
+
+
+Polynomial Polynomial::substitute(const Substitution &sub) const {
+    // precompute the required powers of the substituted polynomials
+    std::vector<std::vector<Polynomial>> powers(vars.size());
+    for (int i = 0; i < vars.size(); ++i) {
+        auto it = sub.find(vars[i]);
+        Polynomial base = (it != sub.end()) ? it->second : Polynomial(vars[i]);
+        powers[i].push_back(Polynomial(numeric(1)));
+        powers[i].push_back(base);
+        for (const Term &term : terms) {
+            while (powers[i].size() <= term.exps[i]) {
+                powers[i].push_back(powers[i].back() * base);
+            }
+        }
+    }
+
+    Polynomial res;
+    for (const Term &term : terms) {
+        Polynomial monomial(term.coeff);
+        for (int i = 0; i < vars.size(); ++i) {
+            if (term.exps[i] > 0) {
+                monomial = monomial * powers[i][term.exps[i]];
+            }
+        }
+        res = res + monomial;
+    }
+    return res;
+}
+
+
+std::vector<Polynomial::Term> Polynomial::termsOver(const std::vector<ExprSymbol> &newVars) const {
+    if (newVars.size() == vars.size()) {
+        return terms;
+    }
+
+    std::vector<int> pos;
+    int j = 0;
+    for (const ExprSymbol &var : vars) {
+        while (ex_is_less()(newVars[j], var)) ++j;
+        pos.push_back(j);
+    }
+
+    std::vector<Term> res;
+    res.reserve(terms.size());
+    for (const Term &term : terms) {
+        Term newTerm{std::vector<int>(newVars.size(), 0), term.coeff, term.degree};
+        for (int i = 0; i < vars.size(); ++i) {
+            newTerm.exps[pos[i]] = term.exps[i];
+        }
+        res.push_back(std::move(newTerm));
+    }
+    return res;
+}
+
+
+Polynomial Polynomial::operator+(const Polynomial &other) const {
+    Polynomial res;
+    std::set_union(vars.begin(), vars.end(), other.vars.begin(), other.vars.end(),
+                   std::back_inserter(res.vars), ex_is_less());
+
+    res.terms = termsOver(res.vars);
+    std::vector<Term> otherTerms = other.termsOver(res.vars);
+    res.terms.insert(res.terms.end(), otherTerms.begin(), otherTerms.end());
+    res.normalize();
+    return res;
+}
+
+
+Polynomial Polynomial::operator*(const Polynomial &other) const {
+    Polynomial res;
+    std::set_union(vars.begin(), vars.end(), other.vars.begin(), other.vars.end(),
+                   std::back_inserter(res.vars), ex_is_less());
+
+    std::vector<Term> lhs = termsOver(res.vars);
+    std::vector<Term> rhs = other.termsOver(res.vars);
+    res.terms.reserve(lhs.size() * rhs.size());
+    for (const Term &a : lhs) {
+        for (const Term &b : rhs) {
+            Term prod{a.exps, a.coeff * b.coeff, a.degree + b.degree};
+            for (int i = 0; i < res.vars.size(); ++i) {
+                prod.exps[i] += b.exps[i];
+            }
+            res.terms.push_back(std::move(prod));
+        }
+    }
+    res.normalize();
+    return res;
+}
+
+
+Polynomial Polynomial::pow(int exp) const {
+    assert(exp >= 0);
+    Polynomial res(numeric(1));
+    Polynomial base = *this;
+    while (exp > 0) {
+        if (exp & 1) res = res * base;
+        exp >>= 1;
+        if (exp > 0) base = base * base;
+    }
+    return res;
+}
+
+
+void Polynomial::normalize() {
+    std::sort(terms.begin(), terms.end(), [](const Term &a, const Term &b) {
+        if (a.degree != b.degree) return a.degree > b.degree;
+        return a.exps > b.exps;
+    });
+
+    // merge equal monomials (which are adjacent) and drop zero terms
+    std::vector<Term> merged;
+    for (Term &term : terms) {
+        if (!merged.empty() && merged.back().exps == term.exps) {
+            merged.back().coeff = merged.back().coeff + term.coeff;
+        } else {
+            if (!merged.empty() && merged.back().coeff.is_zero()) merged.pop_back();
+            merged.push_back(std::move(term));
+        }
+    }
+    if (!merged.empty() && merged.back().coeff.is_zero()) merged.pop_back();
+    terms.swap(merged);
+
+    // drop variables that no longer occur
+    std::vector<bool> used(vars.size(), false);
+    for (const Term &term : terms) {
+        for (int i = 0; i < vars.size(); ++i) {
+            if (term.exps[i] > 0) used[i] = true;
+        }
+    }
+    if (std::find(used.begin(), used.end(), false) == used.end()) {
+        return;
+    }
+
+    std::vector<ExprSymbol> newVars;
+    for (int i = 0; i < vars.size(); ++i) {
+        if (used[i]) newVars.push_back(vars[i]);
+    }
+    for (Term &term : terms) {
+        std::vector<int> exps;
+        for (int i = 0; i < vars.size(); ++i) {
+            if (used[i]) exps.push_back(term.exps[i]);
+        }
+        term.exps.swap(exps);
+    }
+    vars.swap(newVars);
+}
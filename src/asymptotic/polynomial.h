@@ -0,0 +1,91 @@
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
+#include <map>
+#include <vector>
+#include <ginac/ginac.h>
+
+#include "expression.h"
+
+/**
+ * A sparse multivariate polynomial with rational coefficients.
+ * Each term is an exponent vector (over the variables of the polynomial) and a coefficient.
+ * The terms are sorted by descending total degree, so the leading terms come first.
+ *
+ * This is used for the polynomial InftyExpressions of limit problems, to query degrees and
+ * leading terms and to substitute templates without rewriting GiNaC expression trees.
+ */
+class Polynomial {
+public:
+    typedef std::map<ExprSymbol, Polynomial, GiNaC::ex_is_less> Substitution;
+
+    /**
+     * Creates the zero polynomial
+     */
+    Polynomial() {}
+    explicit Polynomial(const GiNaC::numeric &c);
+    explicit Polynomial(const ExprSymbol &var);
+
+    /**
+     * Converts the given expression, which must be polynomial with rational coefficients.
+     * @return false if this is not the case (then res is unchanged)
+     */
+    static bool fromExpression(const GiNaC::ex &ex, Polynomial &res);
+
+    /**
+     * Converts this polynomial back to an (expanded) GiNaC expression
+     */
+    Expression toExpression() const;
+
+    bool isZero() const { return terms.empty(); }
+    int getTermCount() const { return terms.size(); }
+
+    /**
+     * The variables that occur in this polynomial
+     */
+    const std::vector<ExprSymbol>& getVariables() const { return vars; }
+
+    int degree(const ExprSymbol &var) const;
+    int totalDegree() const;
+
+    /**
+     * Returns lcoeff(var) * var^degree(var), i.e., all terms with the highest power of var
+     */
+    Polynomial leadingTerm(const ExprSymbol &var) const;
+
+    /**
+     * Returns the coefficients of 0..degree(var), as polynomials in the remaining variables
+     */
+    std::vector<Polynomial> coefficients(const ExprSymbol &var) const;
+
+    /**
+     * Simultaneously replaces the given variables by polynomials
+     */
+    Polynomial substitute(const Substitution &sub) const;
+
+    Polynomial operator+(const Polynomial &other) const;
+    Polynomial operator*(const Polynomial &other) const;
+    Polynomial pow(int exp) const;
+
+private:
+    struct Term {
+        std::vector<int> exps;
+        GiNaC::numeric coeff;
+        int degree;
+    };
+
+    //index of var in vars, or -1
+    int indexOf(const ExprSymbol &var) const;
+
+    //the terms of this polynomial over newVars, which must be a superset of vars
+    std::vector<Term> termsOver(const std::vector<ExprSymbol> &newVars) const;
+
+    //sorts the terms, merges equal monomials and removes zero terms and unused variables
+    void normalize();
+
+private:
+    std::vector<ExprSymbol> vars; //sorted by GiNaC::ex_is_less
+    std::vector<Term> terms;
+};
+
+#endif //POLYNOMIAL_H
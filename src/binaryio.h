@@ -0,0 +1,78 @@
+/*  This file is part of LoAT.
+ *  Copyright (c) 2015-2016 Matthias Naaf, RWTH Aachen University, Germany
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses>.
+ */
+
+#ifndef BINARYIO_H
+#define BINARYIO_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "exceptions.h"
+
+
+/**
+ * Simple helpers to read and write a compact binary format (e.g. for checkpoints).
+ * Integers are stored as 32 bit values in the byte order of the machine,
+ * strings are prefixed by their length.
+ */
+namespace BinaryIO {
+    EXCEPTION(FormatError,CustomException);
+
+    inline void writeInt(std::ostream &s, int32_t val) {
+        s.write(reinterpret_cast<const char*>(&val),sizeof(val));
+    }
+
+    inline int32_t readInt(std::istream &s) {
+        int32_t val;
+        if (!s.read(reinterpret_cast<char*>(&val),sizeof(val))) throw FormatError("Unexpected end of file");
+        return val;
+    }
+
+    inline void writeString(std::ostream &s, const std::string &str) {
+        writeInt(s,str.size());
+        s.write(str.data(),str.size());
+    }
+
+    inline std::string readString(std::istream &s) {
+        int32_t len = readInt(s);
+        if (len < 0) throw FormatError("Invalid string length");
+        std::string str(len,'\0');
+        if (!s.read(&str[0],len)) throw FormatError("Unexpected end of file");
+        return str;
+    }
+
+    /**
+     * Writes the given magic string (to identify the file type) and version
+     */
+    inline void writeHeader(std::ostream &s, const std::string &magic, int32_t version) {
+        s.write(magic.data(),magic.size());
+        writeInt(s,version);
+    }
+
+    /**
+     * Reads and checks the header written by writeHeader, throws FormatError on mismatch
+     */
+    inline void readHeader(std::istream &s, const std::string &magic, int32_t version) {
+        std::string str(magic.size(),'\0');
+        if (!s.read(&str[0],magic.size()) || str != magic) throw FormatError("Invalid file type");
+        if (readInt(s) != version) throw FormatError("Unsupported version");
+    }
+}
+
+#endif // BINARYIO_H
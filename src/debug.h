@@ -38,6 +38,30 @@
 #endif
 
 
+/* ### Assertion levels ###
+ * ASSERT_LEVEL selects which invariants are checked (usually set by the Makefile):
+ *  1 (cheap): only plain assert, which must only be used for O(1) checks
+ *  2 (audit): also assertAudit, for checks that traverse expressions or guards (e.g. isValidGuard)
+ *  3 (paranoid): also assertParanoid, for checks of the whole graph after every modification
+ */
+
+#ifndef ASSERT_LEVEL
+#define ASSERT_LEVEL 1
+#endif
+
+#if ASSERT_LEVEL >= 2
+#define assertAudit(cond) assert(cond)
+#else
+#define assertAudit(cond) ((void)sizeof(cond))
+#endif
+
+#if ASSERT_LEVEL >= 3
+#define assertParanoid(cond) assert(cond)
+#else
+#define assertParanoid(cond) ((void)sizeof(cond))
+#endif
+
+
 /* ### Some special assertions ### */
 
 #define unreachable() assert(false)
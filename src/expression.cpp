@@ -22,11 +22,13 @@
 #include <map>
 #include <limits>
 #include <functional>
+#include <unordered_map>
 
 #include <z3++.h>
 
 #include "itrs.h"
 #include "z3toolbox.h"
+#include "stats.h"
 
 
 using namespace std;
@@ -55,6 +57,12 @@ z3::expr Expression::ginacToZ3(const GiNaC::ex &term, Z3VariableContext &context
     }
     else if (GiNaC::is_a<GiNaC::mul>(term)) {
         assert(term.nops() > 0);
+        int nonConstFactors = 0;
+        for (int i=0; i < term.nops(); ++i) {
+            if (!GiNaC::is_a<GiNaC::numeric>(term.op(i))) nonConstFactors++;
+        }
+        if (nonConstFactors > 1) context.markNonlinear();
+
         z3::expr res = ginacToZ3(term.op(0),context,fresh,reals);
         for (int i=1; i < term.nops(); ++i) {
             res = res * ginacToZ3(term.op(i),context,fresh,reals);
@@ -63,6 +71,7 @@ z3::expr Expression::ginacToZ3(const GiNaC::ex &term, Z3VariableContext &context
     }
     else if (GiNaC::is_a<GiNaC::power>(term)) {
         assert(term.nops() == 2);
+        context.markNonlinear();
         if (GiNaC::is_a<GiNaC::numeric>(term.op(1))) {
             //rewrite power as multiplication if possible, which z3 can handle much better
             GiNaC::numeric num = GiNaC::ex_to<GiNaC::numeric>(term.op(1));
@@ -84,6 +93,7 @@ z3::expr Expression::ginacToZ3(const GiNaC::ex &term, Z3VariableContext &context
             if (num.is_integer()) {
                 return (reals) ? context.real_val(num.to_int(),1) : context.int_val(num.to_int());
             } else {
+                context.markReal();
                 return context.real_val(num.numer().to_int(),num.denom().to_int());
             }
         } catch (...) { throw GinacZ3ConversionError("Invalid numeric constant (value too large)"); }
@@ -237,7 +247,7 @@ bool Expression::isProperNaturalPower() const {
 
 
 int Expression::getMaxDegree() const {
-    assert(info(GiNaC::info_flags::polynomial));
+    assertAudit(info(GiNaC::info_flags::polynomial));
 
     int res = 0;
     for (auto var : getVariables()) {
@@ -255,7 +265,7 @@ int Expression::getMaxDegree() const {
 
 
 int Expression::getMaxDegree(const GiNaC::lst &vars) const {
-    assert(this->is_polynomial(vars));
+    assertAudit(this->is_polynomial(vars));
 
     int res = 0;
     for (auto var : vars) {
@@ -506,8 +516,47 @@ Complexity Expression::getComplexity(const GiNaC::ex &term) {
 }
 
 
+Expression Expression::expandMemo() const {
+#ifdef EXPAND_MEMO_SIZE
+    //expanding atoms is trivial
+    if (GiNaC::is_a<GiNaC::symbol>(*this) || GiNaC::is_a<GiNaC::numeric>(*this)) {
+        return *this;
+    }
+
+    typedef unordered_map<GiNaC::ex,GiNaC::ex,GiNaC::ex_hash,GiNaC::ex_is_equal> Memo;
+    static Memo current, previous;
+
+    auto it = current.find(*this);
+    if (it != current.end()) {
+        Stats::add(Stats::ExpandMemoHit);
+        return it->second;
+    }
+
+    GiNaC::ex res;
+    it = previous.find(*this);
+    if (it != previous.end()) {
+        Stats::add(Stats::ExpandMemoHit);
+        res = it->second;
+    } else {
+        Stats::add(Stats::ExpandMemoMiss);
+        res = expand();
+    }
+
+    //start a new generation if the current one is full
+    if (current.size() >= EXPAND_MEMO_SIZE/2) {
+        previous.clear();
+        previous.swap(current);
+    }
+    current.emplace(*this,res);
+    return res;
+#else
+    return expand();
+#endif
+}
+
+
 Complexity Expression::getComplexity() const {
-    Expression simple = expand();
+    Expression simple = expandMemo();
     return getComplexity(simple);
 }
 
@@ -567,7 +616,7 @@ GiNaC::ex Expression::simplifyForComplexity(GiNaC::ex term) {
 
 
 Expression Expression::calcComplexityClass() const {
-    GiNaC::ex term = this->expand();
+    GiNaC::ex term = this->expandMemo();
     return simplifyForComplexity(term);
 }
 
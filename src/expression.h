@@ -221,6 +221,12 @@ public:
     z3::expr toZ3(Z3VariableContext &context, bool fresh=false, bool reals=false) const { return ginacToZ3(*this,context,fresh,reals); }
     EXCEPTION(GinacZ3ConversionError,CustomException);
 
+    /**
+     * Like expand(), but the result is memoized (see EXPAND_MEMO_SIZE),
+     * as the same costs and guard terms are expanded again and again
+     */
+    Expression expandMemo() const;
+
     /**
      * Return new expression without any powers of symbols, e.g. x^2 * y^x --> x * y ("5^x" is kept)
      */
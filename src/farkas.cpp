@@ -236,7 +236,7 @@ void FarkasMeterGenerator::restrictToRelevantVariables() {
 
     //reducedGuard must not contain any terms that would be removed per definition
     for (int i=0; i < reducedGuard.size(); ++i) {
-        assert(contains_relevant(reducedGuard[i]));
+        assertAudit(contains_relevant(reducedGuard[i]));
     }
 }
 
@@ -367,7 +367,7 @@ void FarkasMeterGenerator::buildConstraints() {
 
     auto make_constraint = [&](const GiNaC::ex &rel, vector<Expression> &vec) {
         using namespace GuardToolbox;
-        assert(isLinearInequality(rel,itrs.getGinacVarList()));
+        assertAudit(isLinearInequality(rel,itrs.getGinacVarList()));
         GiNaC::ex tmp = makeLessEqual(rel);
         tmp = splitVariablesAndConstants(tmp);
         if (!isTrivialInequality(tmp)) vec.push_back(tmp);
@@ -685,12 +685,15 @@ FarkasMeterGenerator::Result FarkasMeterGenerator::generate(ITRSProblem &itrs, T
     f.createCoefficients(coeffType);
     Timing::done(Timing::FarkasLogic);
 
-    //solve implications
+    //solve implications (generate them first, so the solver is created for the right logic)
+    z3::expr notGuardImplication = f.genNotGuardImplication();
+    z3::expr updateImplication = f.genUpdateImplication();
+    z3::expr nonTrivial = f.genNonTrivial();
     Z3Solver solver(f.context);
-    solver.add(f.genNotGuardImplication());
-    solver.add(f.genUpdateImplication());
-    solver.add(f.genNonTrivial());
-    z3::check_result res = solver.check();
+    solver.add(notGuardImplication);
+    solver.add(updateImplication);
+    solver.add(nonTrivial);
+    z3::check_result res = Z3Toolbox::check(solver,Z3Toolbox::SiteFarkas);
 
     //try to apply instantiation
     GiNaC::exmap replaceFreeSub;
@@ -726,7 +729,7 @@ FarkasMeterGenerator::Result FarkasMeterGenerator::generate(ITRSProblem &itrs, T
             solver.add(f.genNotGuardImplication());
             solver.add(f.genUpdateImplication());
             solver.add(f.genNonTrivial());
-            res = solver.check();
+            res = Z3Toolbox::check(solver,Z3Toolbox::SiteFarkas);
             if (res == z3::sat) {
                 replaceFreeSub = sub;
                 break;
@@ -772,7 +775,7 @@ FarkasMeterGenerator::Result FarkasMeterGenerator::generate(ITRSProblem &itrs, T
     //first try the strictly positive implication, i.e. G => f(x) > 0 (i.e. f(x) >= 1).
     solver.push();
     solver.add(f.genGuardPositiveImplication(true));
-    res = solver.check();
+    res = Z3Toolbox::check(solver,Z3Toolbox::SiteFarkas);
 
     //try the relaxed implication G => f(x) >= 0 as fallback
     if (res != z3::sat) {
@@ -780,7 +783,7 @@ FarkasMeterGenerator::Result FarkasMeterGenerator::generate(ITRSProblem &itrs, T
         debugProblem("Farkas strict positive is " << res << " for: " << t);
         solver.pop(); //remove last assertion
         solver.add(f.genGuardPositiveImplication(false));
-        res = solver.check();
+        res = Z3Toolbox::check(solver,Z3Toolbox::SiteFarkas);
     }
 
     debugFarkas("z3 final res: " << res);
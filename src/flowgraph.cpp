@@ -18,11 +18,15 @@
 #include "flowgraph.h"
 
 #include "preprocess.h"
+#include "guardtoolbox.h"
+#include "guardsampler.h"
+#include "status.h"
 #include "recurrence.h"
 #include "z3toolbox.h"
 #include "farkas.h"
 #include "infinity.h"
 #include "asymptotic/asymptoticbound.h"
+#include "binaryio.h"
 
 #include "debug.h"
 #include "stats.h"
@@ -113,6 +117,34 @@ bool FlowGraph::isEmpty() const {
 }
 
 
+/**
+ * Returns the number of nodes of the given expression tree
+ */
+static int getExpressionSize(const GiNaC::ex &ex) {
+    int size = 1;
+    for (int i=0; i < ex.nops(); ++i) size += getExpressionSize(ex.op(i));
+    return size;
+}
+
+
+Stats::MemoryInfo FlowGraph::getMemoryInfo() const {
+    Stats::MemoryInfo info;
+    for (TransIndex idx : getAllTrans()) {
+        const Transition &trans = getTransData(idx);
+        info.transitions++;
+        info.guardAtoms += trans.guard.size();
+        info.maxExpressionSize = max(info.maxExpressionSize,getExpressionSize(trans.cost));
+        for (const Expression &ex : trans.guard) {
+            info.maxExpressionSize = max(info.maxExpressionSize,getExpressionSize(ex));
+        }
+        for (const auto &it : trans.update) {
+            info.maxExpressionSize = max(info.maxExpressionSize,getExpressionSize(it.second));
+        }
+    }
+    return info;
+}
+
+
 bool FlowGraph::preprocessTransitions(bool eliminateCostConstraints) {
     Timing::Scope _timer(Timing::Preprocess);
     //remove unreachable transitions/nodes
@@ -130,6 +162,7 @@ bool FlowGraph::preprocessTransitions(bool eliminateCostConstraints) {
         for (NodeIndex succ : getSuccessors(node)) {
             if (Timeout::preprocessing()) return changed;
             changed = removeDuplicateTransitions(getTransFromTo(node,succ)) || changed;
+            changed = removeSubsumedTransitions(getTransFromTo(node,succ)) || changed;
         }
     }
     return changed;
@@ -139,10 +172,19 @@ bool FlowGraph::preprocessTransitions(bool eliminateCostConstraints) {
 bool FlowGraph::reduceInitialTransitions() {
     bool changed = false;
     for (TransIndex trans : getTransFrom(initial)) {
-        if (Z3Toolbox::checkExpressionsSAT(getTransData(trans).guard) == z3::unsat) {
+        Transition &data = getTransData(trans);
+        GiNaC::exmap witness;
+        auto z3res = GuardSampler::findModel(data.guard,witness) ? z3::sat : Z3Toolbox::checkExpressionsSATwitness(data.guard,witness);
+        if (z3res == z3::unsat) {
             removeTrans(trans);
             changed = true;
         }
+#ifdef CONTRACT_WITNESS_POOL_SIZE
+        //keep the model to simplify the SAT checks when chaining this transition
+        else if (z3res == z3::sat && GuardToolbox::isSatisfiedBy(data.guard,witness)) {
+            data.witnesses.push_back(witness);
+        }
+#endif
     }
     return changed;
 }
@@ -156,9 +198,10 @@ bool FlowGraph::removeDuplicateInitialTransitions() {
 
 bool FlowGraph::chainLinear() {
     Timing::Scope timer(Timing::Contract);
-    assert(check(&nodes) == Graph::Valid);
+    assertParanoid(check(&nodes) == Graph::Valid);
     Stats::addStep("FlowGraph::chainLinear");
 
+    computePotentials();
     set<NodeIndex> visited;
     bool res = chainLinearPaths(initial,visited);
 #ifdef DEBUG_PRINTSTEPS
@@ -166,16 +209,17 @@ bool FlowGraph::chainLinear() {
     print(cout);
     cout << " \\========== AFTER CONTRACT ===========/ " << endl;
 #endif
-    assert(check(&nodes) == Graph::Valid);
+    assertParanoid(check(&nodes) == Graph::Valid);
     return res;
 }
 
 
 bool FlowGraph::eliminateALocation() {
     Timing::Scope timer(Timing::Contract);
-    assert(check(&nodes) == Graph::Valid);
+    assertParanoid(check(&nodes) == Graph::Valid);
     Stats::addStep("FlowGraph::eliminateALocation");
 
+    computePotentials();
     set<NodeIndex> visited;
     bool res = eliminateALocation(initial, visited);
 #ifdef DEBUG_PRINTSTEPS
@@ -183,16 +227,17 @@ bool FlowGraph::eliminateALocation() {
     print(cout);
     cout << " \\========== AFTER ELIMINATING LOCATIONS ===========/ " << endl;
 #endif
-    assert(check(&nodes) == Graph::Valid);
+    assertParanoid(check(&nodes) == Graph::Valid);
     return res;
 }
 
 
 bool FlowGraph::chainBranches() {
     Timing::Scope timer(Timing::Branches);
-    assert(check(&nodes) == Graph::Valid);
+    assertParanoid(check(&nodes) == Graph::Valid);
     Stats::addStep("FlowGraph::chainBranches");
 
+    computePotentials();
     set<NodeIndex> visited;
     bool res = chainBranchedPaths(initial,visited);
 #ifdef DEBUG_PRINTSTEPS
@@ -200,49 +245,63 @@ bool FlowGraph::chainBranches() {
     print(cout);
     cout << " \\========== AFTER BRANCH CONTRACT ===========/ " << endl;
 #endif
-    assert(check(&nodes) == Graph::Valid);
+    assertParanoid(check(&nodes) == Graph::Valid);
     return res;
 }
 
 
 bool FlowGraph::chainSimpleLoops() {
     Timing::Scope timer(Timing::Contract);
-    assert(check(&nodes) == Graph::Valid);
+    assertParanoid(check(&nodes) == Graph::Valid);
     Stats::addStep("FlowGraph::chainSimpleLoops");
 
-    bool res = false;
+    //the locations are processed independently, the changes are committed in node order
+    vector<SimpleLoopChanges> changes;
     for (NodeIndex node : nodes) {
         if (!getTransFromTo(node, node).empty()) {
-            if (chainSimpleLoops(node)) {
-                res = true;
-            }
-
-            if (Timeout::soft()) return res;
+            changes.push_back(computeSimpleLoopChaining(node));
+            if (Timeout::soft()) break;
         }
     }
 
+    for (const SimpleLoopChanges &change : changes) {
+        commitSimpleLoopChaining(change);
+    }
+    bool res = !changes.empty();
+
 #ifdef DEBUG_PRINTSTEPS
     cout << " /========== AFTER CHAINING SIMPLE LOOPS ===========\\ " << endl;
     print(cout);
     cout << " \\========== AFTER CHAINING SIMPLE LOOPS ===========/ " << endl;
 #endif
-    assert(check(&nodes) == Graph::Valid);
+    assertParanoid(check(&nodes) == Graph::Valid);
     return res;
 }
 
 
 bool FlowGraph::accelerateSimpleLoops() {
     Timing::Scope timer(Timing::Selfloops);
-    assert(check(&nodes) == Graph::Valid);
+    assertParanoid(check(&nodes) == Graph::Valid);
     Stats::addStep("FlowGraph::accelerateSimpleLoops");
 
-    addTransitionToSkipLoops.clear();
+    //continue an interrupted pass (e.g. after resuming from a checkpoint) or start a new one
+    if (pendingAccelerations.empty()) {
+        addTransitionToSkipLoops.clear();
+        computePotentials();
+        for (NodeIndex node : orderByPotential(nodes)) pendingAccelerations.push_back(node);
+    } else {
+        proofout << "Resuming the acceleration of simple loops (" << pendingAccelerations.size() << " locations left)" << endl;
+    }
+
     bool res = false;
-    for (NodeIndex node : nodes) {
-        if (!getTransFromTo(node,node).empty()) {
-            res = accelerateSimpleLoops(node) || res;
-            if (Timeout::soft()) return res;
+    while (!pendingAccelerations.empty()) {
+        NodeIndex node = pendingAccelerations.front();
+        bool interrupted = false;
+        if (nodes.count(node) > 0 && !getTransFromTo(node,node).empty()) {
+            res = accelerateSimpleLoops(node,interrupted) || res;
         }
+        if (!interrupted) pendingAccelerations.pop_front();
+        if (Timeout::soft()) return res;
     }
 #ifdef DEBUG_PRINTSTEPS
     cout << " /========== AFTER SELFLOOPS ==========\\ " << endl;
@@ -250,7 +309,7 @@ bool FlowGraph::accelerateSimpleLoops() {
     cout << " \\========== AFTER SELFLOOPS ==========/ " << endl;
 #endif
 
-    assert(check(&nodes) == Graph::Valid);
+    assertParanoid(check(&nodes) == Graph::Valid);
     return res;
 }
 
@@ -262,13 +321,7 @@ bool FlowGraph::compareTransitions(TransIndex ia, TransIndex ib, bool compareUpd
     if (compareUpdate && a.update.size() != b.update.size()) return false;
     if (!GiNaC::is_a<GiNaC::numeric>(a.cost-b.cost)) return false; //cost equal up to constants
 
-    if (compareUpdate) {
-        for (const auto &itA : a.update) {
-            auto itB = b.update.find(itA.first);
-            if (itB == b.update.end()) return false;
-            if (!itB->second.is_equal(itA.second)) return false;
-        }
-    }
+    if (compareUpdate && !(a.update == b.update)) return false;
     for (int i=0; i < a.guard.size(); ++i) {
         if (!a.guard[i].is_equal(b.guard[i])) return false;
     }
@@ -302,6 +355,149 @@ nextouter:;
 }
 
 
+bool FlowGraph::isSubsumedBy(TransIndex ia, TransIndex ib) const {
+#ifdef SUBSUMPTION_MAX_IMPLICATIONS
+    const Transition &a = getTransData(ia);
+    const Transition &b = getTransData(ib);
+    if (a.update.size() != b.update.size() || !(a.update == b.update)) return false;
+
+    //the atoms of b's guard that are not syntactically part of a's guard must be implied by a's guard
+    ExpressionSet atomsA(a.guard.begin(),a.guard.end());
+    vector<Expression> implications;
+    for (const Expression &ex : b.guard) {
+        if (atomsA.count(ex) == 0) {
+            implications.push_back(ex);
+            if (implications.size() > SUBSUMPTION_MAX_IMPLICATIONS) return false;
+        }
+    }
+
+    //the cost of b must be at least as high
+    Expression costDiff = b.cost - a.cost;
+    if (GiNaC::is_a<GiNaC::numeric>(costDiff)) {
+        if (GiNaC::ex_to<GiNaC::numeric>(costDiff).is_negative()) return false;
+    } else {
+        if (a.cost.has(Expression::Infty) || b.cost.has(Expression::Infty)) return false;
+        implications.push_back(b.cost >= a.cost);
+        if (implications.size() > SUBSUMPTION_MAX_IMPLICATIONS) return false;
+    }
+
+    for (const Expression &ex : implications) {
+        if (!Z3Toolbox::checkTautologicImplication(a.guard,ex,Z3Toolbox::SiteSubsumption)) return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+bool FlowGraph::removeSubsumedTransitions(const std::vector<TransIndex> &trans) {
+    set<TransIndex> toRemove;
+    for (TransIndex a : trans) {
+        for (TransIndex b : trans) {
+            if (Timeout::soft()) goto done;
+            //never remove both of two equivalent transitions
+            if (a == b || toRemove.count(b) > 0) continue;
+            if (isSubsumedBy(a,b)) {
+                toRemove.insert(a);
+                break;
+            }
+        }
+    }
+
+done:
+    for (TransIndex idx : toRemove) {
+        proofout << "Removing subsumed transition: " << idx << "." << endl;
+        Stats::add(Stats::PruneSubsumed);
+        removeTrans(idx);
+    }
+    return !toRemove.empty();
+}
+
+
+bool FlowGraph::eliminationFitsBudget(NodeIndex node) const {
+    if (GlobalFlags::transitionBudget <= 0) return true;
+
+    size_t in = 0, out = 0, atomsIn = 0, atomsOut = 0;
+    for (NodeIndex pre : getPredecessors(node)) {
+        if (pre == node) continue;
+        for (TransIndex idx : getTransFromTo(pre,node)) {
+            in++;
+            atomsIn += getTransData(idx).guard.size();
+        }
+    }
+    for (NodeIndex succ : getSuccessors(node)) {
+        if (succ == node) continue;
+        for (TransIndex idx : getTransFromTo(node,succ)) {
+            out++;
+            atomsOut += getTransData(idx).guard.size();
+        }
+    }
+
+    //chaining replaces all incoming and outgoing transitions by (at most) in*out new ones
+    size_t trans = getTransCount() - in - out + in*out;
+    if (trans > (size_t)GlobalFlags::transitionBudget) return false;
+
+    size_t atoms = 0;
+    for (TransIndex idx : getAllTrans()) {
+        atoms += getTransData(idx).guard.size();
+    }
+    atoms = atoms - atomsIn - atomsOut + out*atomsIn + in*atomsOut;
+    return atoms <= (size_t)GlobalFlags::transitionBudget * GUARD_ATOM_BUDGET_FACTOR;
+}
+
+
+bool FlowGraph::enforceBudget(NodeIndex node) {
+    if (eliminationFitsBudget(node)) return true;
+
+    //first merge the parallel transitions of node, which never loses any runtime
+    for (NodeIndex pre : getPredecessors(node)) {
+        if (pre == node) continue;
+        removeDuplicateTransitions(getTransFromTo(pre,node));
+        removeSubsumedTransitions(getTransFromTo(pre,node));
+    }
+    for (NodeIndex succ : getSuccessors(node)) {
+        if (succ == node) continue;
+        removeDuplicateTransitions(getTransFromTo(node,succ));
+        removeSubsumedTransitions(getTransFromTo(node,succ));
+    }
+    if (eliminationFitsBudget(node)) return true;
+
+    //then keep only the parallel transitions with the highest (syntactic) complexity
+    auto prune = [&](const vector<TransIndex> &parallel) {
+        if (parallel.size() <= PRUNE_MAX_PARALLEL_TRANSITIONS) return;
+
+        vector<pair<Complexity,TransIndex>> byCpx;
+        for (TransIndex idx : parallel) {
+            byCpx.push_back(make_pair(getTransData(idx).cost.getComplexity(),idx));
+        }
+        stable_sort(byCpx.begin(),byCpx.end(),[](const pair<Complexity,TransIndex> &a, const pair<Complexity,TransIndex> &b) {
+            return a.first > b.first;
+        });
+        for (int i=PRUNE_MAX_PARALLEL_TRANSITIONS; i < byCpx.size(); ++i) {
+            proofout << "Removing transition " << byCpx[i].second << " to stay within the transition budget." << endl;
+            Stats::add(Stats::BudgetPruned);
+            removeTrans(byCpx[i].second);
+        }
+    };
+    for (NodeIndex pre : getPredecessors(node)) {
+        if (pre != node) prune(getTransFromTo(pre,node));
+    }
+    for (NodeIndex succ : getSuccessors(node)) {
+        if (succ != node) prune(getTransFromTo(node,succ));
+    }
+    if (eliminationFitsBudget(node)) return true;
+
+    //finally, give the other locations a chance first (but do not block the analysis forever)
+    if (deferredNodes.insert(node).second) {
+        debugGraph("deferring elimination of location " << node << " due to the transition budget");
+        Stats::add(Stats::BudgetDeferred);
+        return false;
+    }
+    return true;
+}
+
+
 bool FlowGraph::isFullyChained() const {
     //ensure that all transitions start from initial node
     for (NodeIndex node : nodes) {
@@ -322,8 +518,15 @@ RuntimeResult FlowGraph::getMaxRuntime() {
     Expression oldMaxExpr(0);
 #endif
 
+    //check the most promising transitions first, so that the checks for the others can be skipped
+    if (GlobalFlags::costDirected) {
+        stable_sort(vec.begin(),vec.end(),[&](TransIndex a, TransIndex b) {
+            return getTransData(a).cost.getComplexity() > getTransData(b).cost.getComplexity();
+        });
+    }
+
     Complexity cpx;
-    RuntimeResult res;
+    RuntimeResult res = bestLowerBound;
 
     for (TransIndex trans : vec) {
 #ifdef FINAL_INFINITY_CHECK
@@ -379,7 +582,7 @@ RuntimeResult FlowGraph::getMaxRuntime() {
 bool FlowGraph::chainTransitionData(Transition &trans, const Transition &followTrans) const {
     //build update replacement list
     GiNaC::exmap updateSubs;
-    for (auto it : trans.update) {
+    for (const auto &it : trans.update) {
         updateSubs[itrs.getGinacSymbol(it.first)] = it.second;
     }
 
@@ -391,13 +594,43 @@ bool FlowGraph::chainTransitionData(Transition &trans, const Transition &followT
     Expression newCost = trans.cost + followTrans.cost.subs(updateSubs);
 
 #ifdef CONTRACT_CHECK_SAT
-    auto z3res = Z3Toolbox::checkExpressionsSAT(newGuard);
+    vector<GiNaC::exmap> newWitnesses;
+    z3::check_result z3res = z3::unknown;
+    GiNaC::exmap witness;
+
+#ifdef CONTRACT_WITNESS_POOL_SIZE
+    //a model of trans.guard often satisfies the new guard as well, which saves the z3 call
+    for (const GiNaC::exmap &oldWitness : trans.witnesses) {
+        if (GuardToolbox::isSatisfiedBy(newGuard,oldWitness)) {
+            newWitnesses.push_back(oldWitness);
+        }
+    }
+
+    if (!newWitnesses.empty()) {
+        Stats::add(Stats::ContractWitness);
+        z3res = z3::sat;
+    }
+#endif
+
+    //a model can often be found by trying some small values, which also saves the z3 call
+    if (z3res != z3::sat && GuardSampler::findModel(newGuard,witness)) {
+        Stats::add(Stats::ContractSampled);
+        newWitnesses.push_back(witness);
+        z3res = z3::sat;
+    }
+
+    if (z3res != z3::sat) {
+        z3res = Z3Toolbox::checkExpressionsSATwitness(newGuard,witness,Z3Toolbox::SiteChaining);
+        if (z3res == z3::sat && GuardToolbox::isSatisfiedBy(newGuard,witness)) {
+            newWitnesses.push_back(witness);
+        }
+    }
 
 #ifdef CONTRACT_CHECK_SAT_APPROXIMATE
     //try to solve an approximate problem instead, as we do not need 100% soundness here
     if (z3res == z3::unknown) {
         debugProblem("Contract unknown, try approximation for: " << trans << " + " << followTrans);
-        z3res = Z3Toolbox::checkExpressionsSATapproximate(newGuard);
+        z3res = Z3Toolbox::checkExpressionsSATapproximate(newGuard,Z3Toolbox::SiteChaining);
     }
 #endif
 
@@ -421,11 +654,15 @@ bool FlowGraph::chainTransitionData(Transition &trans, const Transition &followT
 #endif
 
     trans.guard = std::move(newGuard);
+#ifdef CONTRACT_CHECK_SAT
+    trans.witnesses = std::move(newWitnesses);
+#endif
 
     //modify update (in two steps to allow trans, followTrans to point to the same data)
     UpdateMap newUpdates;
-    for (auto it : followTrans.update) newUpdates[it.first] = it.second.subs(updateSubs);
-    for (auto it : newUpdates) trans.update[it.first] = std::move(it.second);
+    newUpdates.reserve(followTrans.update.size());
+    for (const auto &it : followTrans.update) newUpdates[it.first] = it.second.subs(updateSubs);
+    for (auto &it : newUpdates) trans.update[it.first] = std::move(it.second);
 
     //add up cost, but keep INF if present
     if (trans.cost.isInfty() || followTrans.cost.isInfty()) {
@@ -437,8 +674,29 @@ bool FlowGraph::chainTransitionData(Transition &trans, const Transition &followT
 }
 
 
+void FlowGraph::shareWitnesses(TransIndex first, const Transition &chained) {
+#ifdef CONTRACT_WITNESS_POOL_SIZE
+    vector<GiNaC::exmap> &pool = getTransData(first).witnesses;
+    for (const GiNaC::exmap &witness : chained.witnesses) {
+        if (pool.size() >= CONTRACT_WITNESS_POOL_SIZE) break;
+
+        bool known = false;
+        for (const GiNaC::exmap &other : pool) {
+            known = other.size() == witness.size() && equal(other.begin(),other.end(),witness.begin(),
+                [](const pair<const GiNaC::ex,GiNaC::ex> &a, const pair<const GiNaC::ex,GiNaC::ex> &b) {
+                    return a.first.is_equal(b.first) && a.second.is_equal(b.second);
+                });
+            if (known) break;
+        }
+        if (!known) pool.push_back(witness);
+    }
+#endif
+}
+
+
 bool FlowGraph::chainLinearPaths(NodeIndex node, set<NodeIndex> &visited) {
     if (visited.count(node) > 0) return false;
+    Status::setLocation(node);
 
     bool modified = false;
     bool changed;
@@ -467,7 +725,7 @@ bool FlowGraph::chainLinearPaths(NodeIndex node, set<NodeIndex> &visited) {
     } while (changed);
 
     visited.insert(node);
-    for (NodeIndex next : getSuccessors(node)) {
+    for (NodeIndex next : orderByPotential(getSuccessors(node))) {
         modified = chainLinearPaths(next,visited) || modified;
         if (Timeout::soft()) return modified;
     }
@@ -477,6 +735,7 @@ bool FlowGraph::chainLinearPaths(NodeIndex node, set<NodeIndex> &visited) {
 
 bool FlowGraph::eliminateALocation(NodeIndex node, set<NodeIndex> &visited) {
     if (visited.count(node) > 0) return false;
+    Status::setLocation(node);
     visited.insert(node);
 
     debugGraph("trying to eliminate location " << node);
@@ -492,12 +751,8 @@ bool FlowGraph::eliminateALocation(NodeIndex node, set<NodeIndex> &visited) {
 
     vector<TransIndex> transitionsOut = std::move(getTransFrom(node));
 
-    set<NodeIndex> nextNodes;
-    if (predecessors.count(node) > 0 // simple loop
-        || transitionsIn.empty()
-        || transitionsOut.empty()) {
-
-        for (NodeIndex next : getSuccessors(node)) {
+    auto tryNextNodes = [&]() {
+        for (NodeIndex next : orderByPotential(getSuccessors(node))) {
             if (eliminateALocation(next, visited)) {
                 return true;
             }
@@ -508,10 +763,29 @@ bool FlowGraph::eliminateALocation(NodeIndex node, set<NodeIndex> &visited) {
         }
 
         return false;
+    };
+
+    set<NodeIndex> nextNodes;
+    if (predecessors.count(node) > 0 // simple loop
+        || transitionsIn.empty()
+        || transitionsOut.empty()) {
+        return tryNextNodes();
     }
 
     assert(node != initial);
 
+    //avoid blowing up the graph, this might remove some transitions of node
+    if (!enforceBudget(node)) {
+        return tryNextNodes();
+    }
+    transitionsIn.clear();
+    for (NodeIndex pre : getPredecessors(node)) {
+        for (TransIndex transition : getTransFromTo(pre, node)) {
+            transitionsIn.push_back(transition);
+        }
+    }
+    transitionsOut = getTransFrom(node);
+
     bool addedTrans = false;
     for (TransIndex out : transitionsOut) {
         const Transition &outTransData = getTransData(out);
@@ -520,6 +794,7 @@ bool FlowGraph::eliminateALocation(NodeIndex node, set<NodeIndex> &visited) {
             Transition inTransData = getTransData(in);
 
             if (chainTransitionData(inTransData, outTransData)) {
+                shareWitnesses(in, inTransData);
                 addedTrans = true;
                 addTrans(getTransSource(in), getTransTarget(out), inTransData);
                 Stats::add(Stats::ContractLinear);
@@ -546,6 +821,7 @@ bool FlowGraph::eliminateALocation(NodeIndex node, set<NodeIndex> &visited) {
 
 
 bool FlowGraph::chainBranchedPaths(NodeIndex node, set<NodeIndex> &visited) {
+    Status::setLocation(node);
     //avoid cycles even in branched mode. Contract a cycle to a selfloop and stop.
     if (visited.count(node) > 0) return false;
 
@@ -562,6 +838,14 @@ bool FlowGraph::chainBranchedPaths(NodeIndex node, set<NodeIndex> &visited) {
             assert(getPredecessors(mid).count(node) == 1);
             if (getPredecessors(mid).size() > 1) continue; //this is a "V" pattern, try contracting the rest first [node = loop head]
 
+            //avoid blowing up the graph, this might remove some transitions of mid (possibly even t)
+            if (!enforceBudget(mid)) continue;
+            vector<TransIndex> midin = getTransFromTo(node,mid);
+            if (std::find(midin.begin(),midin.end(),t) == midin.end()) {
+                changed = true;
+                continue;
+            }
+
             //now contract with all children of mid, to "skip" mid
             vector<TransIndex> midout = getTransFrom(mid);
             if (midout.empty()) continue;
@@ -572,6 +856,7 @@ bool FlowGraph::chainBranchedPaths(NodeIndex node, set<NodeIndex> &visited) {
 
                 Transition data = getTransData(t);
                 if (chainTransitionData(data,getTransData(t2))) {
+                    shareWitnesses(t,data);
                     addTrans(node,getTransTarget(t2),data);
                     Stats::add(Stats::ContractBranch);
                 } else {
@@ -593,7 +878,7 @@ bool FlowGraph::chainBranchedPaths(NodeIndex node, set<NodeIndex> &visited) {
 
     //this node cannot be contracted further, try its children
     visited.insert(node);
-    for (NodeIndex next : getSuccessors(node)) {
+    for (NodeIndex next : orderByPotential(getSuccessors(node))) {
         modified = chainBranchedPaths(next,visited) || modified;
         if (Timeout::soft()) return modified;
     }
@@ -619,11 +904,15 @@ bool FlowGraph::canNest(const Transition &inner, const Transition &outer) const
 }
 
 
-bool FlowGraph::chainSimpleLoops(NodeIndex node) {
+FlowGraph::SimpleLoopChanges FlowGraph::computeSimpleLoopChaining(NodeIndex node) const {
+    Status::setLocation(node);
     debugGraph("Chaining simple loops.");
     assert(node != initial);
     assert(!getTransFromTo(node, node).empty());
 
+    SimpleLoopChanges changes;
+    changes.node = node;
+
     set<NodeIndex> predecessors = std::move(getPredecessors(node));
     predecessors.erase(node);
 
@@ -644,30 +933,51 @@ bool FlowGraph::chainSimpleLoops(NodeIndex node) {
             Transition transData = getTransData(pair.first);
 
             if (chainTransitionData(transData, simpleLoopTransData)) {
-                addTrans(getTransSource(pair.first), node, transData);
+                changes.added.push_back(std::make_pair(pair.first, std::move(transData)));
                 Stats::add(Stats::ContractLinear);
                 pair.second = true;
             }
 
         }
 
-        debugGraph("removing simple loop " << simpleLoop);
-        removeTrans(simpleLoop);
+        changes.removed.push_back(simpleLoop);
     }
 
     for (const std::pair<TransIndex,bool> &pair : transitions) {
         if (pair.second && !(addTransitionToSkipLoops.count(node) > 0)) {
-            debugGraph("removing transition " << pair.first);
-            removeTrans(pair.first);
+            changes.removed.push_back(pair.first);
         }
     }
 
-    return true;
+    return changes;
 }
 
 
-bool FlowGraph::accelerateSimpleLoops(NodeIndex node) {
-    vector<TransIndex> loops = getTransFromTo(node,node);
+void FlowGraph::commitSimpleLoopChaining(const SimpleLoopChanges &changes) {
+    for (const auto &it : changes.added) {
+        shareWitnesses(it.first, it.second);
+        addTrans(getTransSource(it.first), changes.node, it.second);
+    }
+
+    for (TransIndex trans : changes.removed) {
+        debugGraph("removing transition " << trans);
+        removeTrans(trans);
+    }
+}
+
+
+bool FlowGraph::accelerateSimpleLoops(NodeIndex node, bool &interrupted) {
+    Status::setLocation(node);
+    interrupted = false;
+
+    //if the last call for node was interrupted, the loops resulting from it are kept as they are
+    vector<TransIndex> loops;
+    for (TransIndex loop : getTransFromTo(node,node)) {
+        if (acceleratedLoops.count(loop) == 0) loops.push_back(loop);
+    }
+    acceleratedLoops.clear();
+    if (loops.empty()) return false;
+
     proofout << "Eliminating " << loops.size() << " self-loops for location ";
     if (node < itrs.getTermCount()) proofout << itrs.getTerm(node).name; else proofout << "[" << node << "]";
     proofout << endl;
@@ -700,14 +1010,18 @@ bool FlowGraph::accelerateSimpleLoops(NodeIndex node) {
     set<TransIndex> todo_remove;
     map<TransIndex,TransIndex> map_to_original; //maps ranked transition to the original transition
 
+    //the loops that still have to be processed (needed if the acceleration is interrupted)
+    set<TransIndex> pendingLoops(loops.begin(),loops.end());
+
     //use index to iterate, as loops is appended while iterating
     int oldloopcount = loops.size();
     for (int lopidx=0; lopidx < loops.size(); ++lopidx) {
-        if (Timeout::soft()) goto timeout;
+        if (Timeout::soft()) { interrupted = true; goto timeout; }
         TransIndex tidx = loops[lopidx];
 
         //remove the original selfloop later
         todo_remove.insert(tidx);
+        pendingLoops.erase(tidx);
 
         //abort early on INF selfloops
         if (getTransData(tidx).cost.isInfty()) {
@@ -741,11 +1055,13 @@ bool FlowGraph::accelerateSimpleLoops(NodeIndex node) {
             Transition dataAB = data; //copy
             dataAB.guard.push_back(itrs.getGinacSymbol(A) > itrs.getGinacSymbol(B));
             loops.push_back(addTrans(node,node,dataAB));
+            pendingLoops.insert(loops.back());
 
             //add B > A to the guard, process resulting selfloop later
             Transition dataBA = data; //copy
             dataBA.guard.push_back(itrs.getGinacSymbol(B) > itrs.getGinacSymbol(A));
             loops.push_back(addTrans(node,node,dataBA));
+            pendingLoops.insert(loops.back());
 
             //ConflictVar is really just Unsat
             result = FarkasMeterGenerator::Unsat;
@@ -814,7 +1130,7 @@ bool FlowGraph::accelerateSimpleLoops(NodeIndex node) {
         set<TransIndex> added_nested;
         for (TransIndex inner : added_ranked) {
             for (TransIndex outer : added_unranked) {
-                if (Timeout::soft()) goto timeout;
+                if (Timeout::soft()) { interrupted = true; goto timeout; }
 
                 //dont nest a loop with itself or with its original transition (save time)
                 if (inner == outer) continue;
@@ -879,7 +1195,7 @@ bool FlowGraph::accelerateSimpleLoops(NodeIndex node) {
 #ifdef NESTING_CHAIN_RANKED
         for (TransIndex first : added_ranked) {
             for (TransIndex second : added_ranked) {
-                if (Timeout::soft()) goto timeout;
+                if (Timeout::soft()) { interrupted = true; goto timeout; }
                 if (first == second) continue;
                 Transition chained = getTransData(first);
                 if (chainTransitionData(chained,getTransData(second))) {
@@ -908,6 +1224,13 @@ timeout:
 
     removeDuplicateTransitions(getTransFromTo(node,node));
 
+    //remember the loops that need not be processed again when resuming
+    if (interrupted) {
+        for (TransIndex loop : getTransFromTo(node,node)) {
+            if (pendingLoops.count(loop) == 0) acceleratedLoops.insert(loop);
+        }
+    }
+
     return true; //always changed as old transition is removed
 }
 
@@ -926,6 +1249,11 @@ bool FlowGraph::pruneTransitions() {
     for (NodeIndex node : nodes) {
         if (Timeout::soft()) break;
         for (NodeIndex pre : getPredecessors(node)) {
+            //first remove the transitions that are obviously not needed
+            if (removeSubsumedTransitions(getTransFromTo(pre,node))) {
+                changed = true;
+            }
+
             const vector<TransIndex> &parallel = getTransFromTo(pre,node);
 
             if (parallel.size() > PRUNE_MAX_PARALLEL_TRANSITIONS) {
@@ -1011,6 +1339,303 @@ bool FlowGraph::removeConstLeafsAndUnreachable() {
 
 
 
+/* ### Cost-directed exploration ### */
+
+/**
+ * Scales the given complexity by the given degree (e.g. a cost of complexity 2 after an update of degree 3),
+ * where exponential and unknown complexities are not scaled.
+ */
+static Complexity scaleComplexity(Complexity cpx, Complexity degree) {
+    if (cpx <= 0 || degree <= 1) return cpx;
+    if (cpx >= Expression::ComplexExp) return cpx;
+    if (degree >= Expression::ComplexExp) return Expression::ComplexExp;
+    return cpx * degree;
+}
+
+/**
+ * The syntactic complexity of the given cost, where unknown complexities are assumed to be unbounded
+ */
+static Complexity optimisticComplexity(const Expression &cost) {
+    Complexity cpx = cost.getComplexity();
+    return (cpx == Expression::ComplexNone) ? Expression::ComplexInfty : cpx;
+}
+
+/**
+ * The maximum degree of the update's right-hand sides (at least 1),
+ * i.e. the factor by which the degree of later costs might be increased
+ */
+static Complexity getUpdateDegree(const Transition &trans) {
+    Complexity degree = 1;
+    for (const auto &it : trans.update) {
+        Complexity cpx = it.second.getComplexity();
+        if (cpx == Expression::ComplexNone) return Expression::ComplexExp;
+        degree = max(degree,cpx);
+    }
+    return degree;
+}
+
+
+Complexity FlowGraph::estimateAcceleratedComplexity(const Transition &loop, Complexity &updateDegree) const {
+    updateDegree = 1;
+    if (loop.cost.isInfty()) return Expression::ComplexInfty;
+
+    //non-linear updates (and linear updates like x=2*x) usually result in exponential growth
+    if (getUpdateDegree(loop) > 1) {
+        updateDegree = Expression::ComplexExp;
+        return Expression::ComplexExp;
+    }
+
+    for (const auto &it : loop.update) {
+        ExprSymbol self = itrs.getGinacSymbol(it.first);
+        GiNaC::ex coeff = it.second.expand().coeff(self,1);
+        if (!GiNaC::is_a<GiNaC::numeric>(coeff) || (!coeff.is_zero() && coeff.compare(1) != 0)) {
+            updateDegree = Expression::ComplexExp;
+            return Expression::ComplexExp;
+        }
+
+        //updates like x=x+y increase the degree of x by the degree of the metering function
+        ExprSymbolSet vars;
+        it.second.collectVariables(vars);
+        vars.erase(self);
+        if (!vars.empty()) updateDegree = updateDegree + 1;
+    }
+
+    //the metering function is (usually) linear
+    return scaleComplexity(optimisticComplexity(loop.cost),updateDegree) + 1;
+}
+
+
+Complexity FlowGraph::getPotentialComplexity(NodeIndex node, set<NodeIndex> &onPath) {
+    auto it = potential.find(node);
+    if (it != potential.end()) return it->second;
+
+    //a cycle over several nodes, we cannot estimate its acceleration yet
+    if (onPath.count(node) > 0) return Expression::ComplexInfty;
+    onPath.insert(node);
+
+    //accelerated simple loops might increase the degree of all following transitions
+    Complexity res = 0;
+    Complexity loopDegree = 1;
+    for (TransIndex loop : getTransFromTo(node,node)) {
+        Complexity degree;
+        res = max(res,estimateAcceleratedComplexity(getTransData(loop),degree));
+        loopDegree = max(loopDegree,degree);
+    }
+
+    for (TransIndex trans : getTransFrom(node)) {
+        NodeIndex next = getTransTarget(trans);
+        if (next == node) continue;
+
+        const Transition &data = getTransData(trans);
+        Complexity nextCpx = scaleComplexity(getPotentialComplexity(next,onPath),getUpdateDegree(data));
+        res = max(res,scaleComplexity(max(optimisticComplexity(data.cost),nextCpx),loopDegree));
+    }
+
+    onPath.erase(node);
+    potential[node] = res;
+    return res;
+}
+
+
+void FlowGraph::computePotentials() {
+    potential.clear();
+    if (!GlobalFlags::costDirected) return;
+
+    set<NodeIndex> onPath;
+    getPotentialComplexity(initial,onPath);
+}
+
+
+vector<NodeIndex> FlowGraph::orderByPotential(const set<NodeIndex> &nodeSet) const {
+    vector<NodeIndex> res(nodeSet.begin(),nodeSet.end());
+    if (!GlobalFlags::costDirected) return res;
+
+    //nodes without estimate (e.g. created during the current pass) are explored first
+    auto getPotential = [&](NodeIndex node) {
+        auto it = potential.find(node);
+        return (it != potential.end()) ? it->second : Expression::ComplexInfty;
+    };
+    stable_sort(res.begin(),res.end(),[&](NodeIndex a, NodeIndex b) {
+        return getPotential(a) > getPotential(b);
+    });
+    return res;
+}
+
+
+bool FlowGraph::skipHopelessPaths() {
+    if (!GlobalFlags::costDirected) return false;
+    Stats::addStep("FlowGraph::skipHopelessPaths");
+
+    //determine the complexity of all paths that are already fully chained
+    vector<TransIndex> hopeless;
+    for (TransIndex trans : getTransFrom(initial)) {
+        if (Timeout::soft()) break;
+        NodeIndex next = getTransTarget(trans);
+        if (next == initial || !getTransFrom(next).empty()) continue;
+
+        const Transition &data = getTransData(trans);
+        if (data.cost.getComplexity() <= bestLowerBound.cpx) {
+            hopeless.push_back(trans);
+            continue;
+        }
+
+        auto checkRes = AsymptoticBound::determineComplexity(itrs, data.guard, data.cost, true);
+        if (checkRes.cpx > bestLowerBound.cpx) {
+            proofout << "Found new lower bound " << Expression::complexityString(checkRes.cpx) << ", because: " << checkRes.reason << "." << endl;
+            bestLowerBound.cpx = checkRes.cpx;
+            bestLowerBound.bound = checkRes.cost;
+            bestLowerBound.reducedCpx = checkRes.reducedCpx;
+            bestLowerBound.guard = data.guard;
+            Status::setBestComplexity(Expression::complexityString(bestLowerBound.cpx));
+        } else {
+            hopeless.push_back(trans);
+        }
+    }
+    if (bestLowerBound.cpx <= 0) return false;
+
+    //remove the fully chained paths that cannot improve the lower bound.
+    //Paths that still have to be chained are kept, as their potential is only a heuristic estimate
+    //(e.g. nesting parallel simple loops can exceed it), which is used to order the exploration.
+    bool changed = false;
+    for (TransIndex trans : hopeless) {
+        proofout << "Skipping transition " << trans << ", it cannot improve the lower bound " << Expression::complexityString(bestLowerBound.cpx) << "." << endl;
+        removeTrans(trans);
+        changed = true;
+    }
+
+    if (changed) removeConstLeafsAndUnreachable();
+    return changed;
+}
+
+
+
+/* ### Checkpoints ### */
+
+static const string CHECKPOINT_MAGIC = "LoATckpt";
+static const int CHECKPOINT_VERSION = 2;
+
+void FlowGraph::saveCheckpoint(ostream &s) const {
+    BinaryIO::writeHeader(s,CHECKPOINT_MAGIC,CHECKPOINT_VERSION);
+    itrs.saveVariables(s);
+
+    BinaryIO::writeInt(s,initial);
+    BinaryIO::writeInt(s,nextNode);
+    BinaryIO::writeInt(s,nodes.size());
+    for (NodeIndex node : nodes) BinaryIO::writeInt(s,node);
+    BinaryIO::writeInt(s,addTransitionToSkipLoops.size());
+    for (NodeIndex node : addTransitionToSkipLoops) BinaryIO::writeInt(s,node);
+    BinaryIO::writeInt(s,pendingAccelerations.size());
+    for (NodeIndex node : pendingAccelerations) BinaryIO::writeInt(s,node);
+
+    //all expressions are collected in a single archive (which is written last), in the order they are read
+    GiNaC::archive ar;
+
+    vector<TransIndex> transitions = getAllTrans();
+    BinaryIO::writeInt(s,transitions.size());
+    for (TransIndex trans : transitions) {
+        const Transition &data = getTransData(trans);
+        BinaryIO::writeInt(s,getTransSource(trans));
+        BinaryIO::writeInt(s,getTransTarget(trans));
+        BinaryIO::writeInt(s,acceleratedLoops.count(trans) > 0 ? 1 : 0);
+        BinaryIO::writeInt(s,data.guard.size());
+        for (const Expression &ex : data.guard) ar.archive_ex(ex,"guard");
+        BinaryIO::writeInt(s,data.update.size());
+        for (const auto &it : data.update) {
+            BinaryIO::writeInt(s,it.first);
+            ar.archive_ex(it.second,"update");
+        }
+        ar.archive_ex(data.cost,"cost");
+    }
+
+    //the lower bound found by cost-directed exploration (the corresponding transitions might be removed)
+    BinaryIO::writeInt(s,bestLowerBound.reducedCpx ? 1 : 0);
+    BinaryIO::writeInt(s,bestLowerBound.guard.size());
+    for (const Expression &ex : bestLowerBound.guard) ar.archive_ex(ex,"guard");
+    ar.archive_ex(bestLowerBound.bound,"bound");
+    ar.archive_ex(bestLowerBound.cpx.toExpr(),"cpx");
+
+    s << ar;
+}
+
+
+void FlowGraph::loadCheckpoint(istream &s) {
+    BinaryIO::readHeader(s,CHECKPOINT_MAGIC,CHECKPOINT_VERSION);
+    itrs.loadVariables(s);
+
+    auto readCount = [&]() {
+        int count = BinaryIO::readInt(s);
+        if (count < 0) throw BinaryIO::FormatError("Invalid checkpoint");
+        return count;
+    };
+
+    //remove the current graph
+    for (TransIndex trans : getAllTrans()) removeTrans(trans);
+    nodes.clear();
+    addTransitionToSkipLoops.clear();
+    pendingAccelerations.clear();
+    acceleratedLoops.clear();
+    potential.clear();
+
+    initial = BinaryIO::readInt(s);
+    nextNode = BinaryIO::readInt(s);
+    for (int i=readCount(); i > 0; --i) nodes.insert(BinaryIO::readInt(s));
+    for (int i=readCount(); i > 0; --i) addTransitionToSkipLoops.insert(BinaryIO::readInt(s));
+    for (int i=readCount(); i > 0; --i) pendingAccelerations.push_back(BinaryIO::readInt(s));
+
+    //the expressions are stored after the graph structure, so remember the structure first
+    struct TransInfo {
+        NodeIndex from, to;
+        bool accelerated;
+        int guardSize;
+        vector<VariableIndex> updateVars;
+    };
+    vector<TransInfo> infos(readCount());
+    for (TransInfo &info : infos) {
+        info.from = BinaryIO::readInt(s);
+        info.to = BinaryIO::readInt(s);
+        info.accelerated = BinaryIO::readInt(s) != 0;
+        info.guardSize = readCount();
+        for (int i=readCount(); i > 0; --i) info.updateVars.push_back(BinaryIO::readInt(s));
+        if (nodes.count(info.from) == 0 || nodes.count(info.to) == 0) throw BinaryIO::FormatError("Invalid checkpoint");
+    }
+    bool reducedCpx = BinaryIO::readInt(s) != 0;
+    int boundGuardSize = readCount();
+
+    GiNaC::archive ar;
+    if (!(s >> ar)) throw BinaryIO::FormatError("Unexpected end of file");
+
+    //restore the expressions with the symbols of the itrs (symbols with the same name are not identical in GiNaC)
+    GiNaC::lst symbols = itrs.getGinacVarList();
+    symbols.append(Expression::Infty);
+    unsigned nextExpr = 0;
+    auto readExpr = [&]() -> Expression {
+        if (nextExpr >= ar.num_expressions()) throw BinaryIO::FormatError("Missing expressions in checkpoint");
+        return ar.unarchive_ex(symbols,nextExpr++);
+    };
+
+    for (const TransInfo &info : infos) {
+        Transition data;
+        for (int i=0; i < info.guardSize; ++i) data.guard.push_back(readExpr());
+        for (VariableIndex var : info.updateVars) data.update[var] = readExpr();
+        data.cost = readExpr();
+        TransIndex trans = addTrans(info.from,info.to,std::move(data));
+        if (info.accelerated) acceleratedLoops.insert(trans);
+    }
+
+    bestLowerBound.reducedCpx = reducedCpx;
+    bestLowerBound.guard.clear();
+    for (int i=0; i < boundGuardSize; ++i) bestLowerBound.guard.push_back(readExpr());
+    bestLowerBound.bound = readExpr();
+    Expression cpxExpr = readExpr();
+    if (!GiNaC::is_a<GiNaC::numeric>(cpxExpr)) throw BinaryIO::FormatError("Invalid checkpoint");
+    GiNaC::numeric cpx = GiNaC::ex_to<GiNaC::numeric>(cpxExpr);
+    bestLowerBound.cpx = Complexity(cpx.numer().to_int(),cpx.denom().to_int());
+
+    assertParanoid(check(&nodes) == Graph::Valid);
+}
+
+
+
 /* ### Recovering after timeout ### */
 
 bool FlowGraph::removeIrrelevantTransitions(NodeIndex curr, set<NodeIndex> &visited) {
@@ -1037,7 +1662,8 @@ RuntimeResult FlowGraph::getMaxPartialResult() {
     printForProof();
 
     //contract and always compute the maximum complexity to allow abortion
-    RuntimeResult res;
+    RuntimeResult res = bestLowerBound;
+    if (res.cpx == Expression::ComplexInfty || res.cpx == Expression::ComplexNonterm) goto done;
 
     while (true) {
         //always check for timeouts
@@ -1219,7 +1845,7 @@ void FlowGraph::printKoAT() const {
             }
 
             //cost
-            proofout << ") -{" << data.cost.expand() << "," << data.cost.expand() << "}> ";
+            proofout << ") -{" << data.cost.expandMemo() << "," << data.cost.expandMemo() << "}> ";
 
             //rhs update
             printNode(getTransTarget(trans));
@@ -1272,7 +1898,7 @@ void FlowGraph::printDot(ostream &s, int step, const string &desc) const {
                     s << data.guard[i];
                 }
                 s << "], ";
-                s << data.cost.expand(); //simplify for readability
+                s << data.cost.expandMemo(); //simplify for readability
                 s << "\\l";
             }
             s << "\"];" << endl;
@@ -1281,7 +1907,7 @@ void FlowGraph::printDot(ostream &s, int step, const string &desc) const {
     s << "}" << endl;
 }
 
-void FlowGraph::printDotText(ostream &s, int step, const string &txt) const {
+void FlowGraph::printDotText(ostream &s, int step, const string &txt) {
     s << "subgraph cluster_" << step << " {" << endl;
     s << "sortv=" << step << ";" << endl;
     s << "label=\"" << step << ": " << "Result" << "\";" << endl;
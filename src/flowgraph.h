@@ -23,6 +23,9 @@
 #include "graph.h"
 #include "itrs.h"
 #include "expression.h"
+#include "stats.h"
+
+#include <deque>
 
 
 /**
@@ -33,6 +36,9 @@ struct Transition {
     GuardList guard;
     UpdateMap update;
     Expression cost;
+
+    //known models of the guard (might be outdated if the guard is modified, so they must be checked before use)
+    std::vector<GiNaC::exmap> witnesses;
 };
 
 std::ostream& operator<<(std::ostream &, const Transition &);
@@ -86,7 +92,7 @@ public:
      * @param desc a description of the current subgraph
      */
     void printDot(std::ostream &s, int step, const std::string &desc) const;
-    void printDotText(std::ostream &s, int step, const std::string &desc) const;
+    static void printDotText(std::ostream &s, int step, const std::string &desc);
 
     /**
      * Print the graph in the T2 format, to allow conversion from koat -> T2.
@@ -150,6 +156,8 @@ public:
      * Replaces all simple loops with accelerated simple loops
      * by searching for metering functions and iterated costs/updates.
      * Also handles nesting and chaining of parallel simple loops (where possible).
+     * @note if this is interrupted by the soft timeout, the next call (also after saving and loading
+     * a checkpoint) continues with the remaining locations instead of starting a new pass
      * @return true iff the graph was modified
      *         (which is always the case if any simple loops were present)
      */
@@ -162,6 +170,17 @@ public:
      */
     bool pruneTransitions();
 
+    /**
+     * Cost-directed exploration (only used if GlobalFlags::costDirected is set).
+     * Determines the complexity of all transitions from the initial location that cannot be chained further,
+     * the best result is kept as the current lower bound (and is the starting point of getMaxRuntime).
+     * Afterwards, those of these transitions are removed that cannot improve the current lower bound.
+     * @note transitions that can still be chained are never removed, as their potential (see getPotentialComplexity)
+     * is only a heuristic estimate
+     * @return true iff the graph was modified
+     */
+    bool skipHopelessPaths();
+
     /**
      * Returns true iff all paths have a length of at most 1
      */
@@ -177,6 +196,30 @@ public:
      */
     RuntimeResult getMaxPartialResult();
 
+    /**
+     * Returns the number of transitions, guard atoms and the size of the largest expression
+     * (the memory related fields are not set, see Analysis)
+     */
+    Stats::MemoryInfo getMemoryInfo() const;
+
+    /**
+     * Returns the number of locations
+     */
+    size_t getNodeCount() const { return nodes.size(); }
+
+    /**
+     * Writes the current state of the analysis (the graph and all variables of the itrs)
+     * to the given stream, in a compact binary format that can be restored by loadCheckpoint
+     */
+    void saveCheckpoint(std::ostream &s) const;
+
+    /**
+     * Replaces the current state of the analysis by the one written by saveCheckpoint
+     * @note the itrs must be loaded from the same input file as when saving the checkpoint
+     * @note throws ITRSProblem::FileError or BinaryIO::FormatError if the checkpoint is invalid
+     */
+    void loadCheckpoint(std::istream &s);
+
 private:
     /**
      * Adds the given rule to this graph, calculating the required update
@@ -198,6 +241,13 @@ private:
      */
     bool chainTransitionData(Transition &trans, const Transition &followTrans) const;
 
+    /**
+     * Adds the witnesses of the chained transition to the witnesses of the first transition (see CONTRACT_WITNESS_POOL_SIZE),
+     * as every model of the chained guard is also a model of the first transition's guard
+     * @param first the transition that was chained (and is not modified by chaining), chained is the result
+     */
+    void shareWitnesses(TransIndex first, const Transition &chained);
+
     /**
      * Internal function for chainLinear
      * @return true iff the graph was modified
@@ -223,19 +273,36 @@ private:
     bool canNest(const Transition &inner, const Transition &outer) const;
 
     /**
-     * Apply chaining to the simple loops of node
-     * @return true iff the graph was modified
+     * The changes of chaining the simple loops of a single location (see computeSimpleLoopChaining)
+     */
+    struct SimpleLoopChanges {
+        NodeIndex node;
+        std::vector<std::pair<TransIndex,Transition>> added; //chained transitions, with the transition they are based on
+        std::vector<TransIndex> removed;
+    };
+
+    /**
+     * Computes the result of chaining the simple loops of node, without modifying the graph
+     * @note the changes only refer to node's simple loops and incoming transitions,
+     * so the changes of different locations are independent of each other
+     */
+    SimpleLoopChanges computeSimpleLoopChaining(NodeIndex node) const;
+
+    /**
+     * Applies the changes computed by computeSimpleLoopChaining to the graph
      */
-    bool chainSimpleLoops(NodeIndex node);
+    void commitSimpleLoopChaining(const SimpleLoopChanges &changes);
 
     /**
      * Replaces all simple loops of the given location with accelerated simple loops
      * by searching for metering functions and iterated costs/updates.
      * Also handles nesting and chaining of parallel simple loops (where possible).
+     * @param interrupted is set to true if this was stopped by the soft timeout (the remaining loops are kept),
+     * a subsequent call for node then only processes the loops that were not processed yet (see acceleratedLoops)
      * @return true iff the graph was modified
      *         (which is always the case if any selfloops were present)
      */
-    bool accelerateSimpleLoops(NodeIndex node);
+    bool accelerateSimpleLoops(NodeIndex node, bool &interrupted);
 
     /**
      * A simple syntactic comparision. Returns true iff a and b are equal up to constants
@@ -253,6 +320,32 @@ private:
      */
     bool removeDuplicateTransitions(const std::vector<TransIndex> &trans, bool compareUpdate = true);
 
+    /**
+     * Returns true if a is subsumed by b, i.e., b has the same update, a weaker guard and at least the cost of a
+     * (so every run using a can also use b, with at least the same cost)
+     * @note the guards are compared syntactically first, z3 is only used for close candidates (see SUBSUMPTION_MAX_IMPLICATIONS)
+     */
+    bool isSubsumedBy(TransIndex a, TransIndex b) const;
+
+    /**
+     * Removes all transitions that are subsumed by another one of the given (parallel) transitions
+     * @return true iff the graph was modified
+     */
+    bool removeSubsumedTransitions(const std::vector<TransIndex> &trans);
+
+    /**
+     * Returns true if the graph stays within the budget (see TRANSITION_BUDGET) when the given node is eliminated,
+     * i.e. if all incoming transitions are chained with all outgoing transitions (selfloops are ignored)
+     */
+    bool eliminationFitsBudget(NodeIndex node) const;
+
+    /**
+     * Called before eliminating the given node. If this would exceed the budget, the transitions of this node
+     * are merged and pruned (see TRANSITION_BUDGET) until the budget is met.
+     * @return false if the elimination should be deferred (only once per node)
+     */
+    bool enforceBudget(NodeIndex node);
+
     /**
      * Removes all unreachable nodes and transitions to leaves with constant cost, as they have no impact on the runtime
      * @return true iff the graph was modified
@@ -271,6 +364,33 @@ private:
      */
     std::set<VariableIndex> getBoundVariables(const Transition &trans) const;
 
+    /**
+     * Recomputes the optimistic complexity of all nodes reachable from the initial node (if GlobalFlags::costDirected is set)
+     */
+    void computePotentials();
+
+    /**
+     * Returns an optimistic estimate of the complexity of all paths starting in node, based on the syntactic
+     * complexity of the costs and a rough estimate for the acceleration of simple loops.
+     * @note this is not a guaranteed over-approximation (e.g. nesting parallel simple loops can exceed it),
+     * so it must only be used to order the exploration
+     * @note the results are cached in potential, cycles over several nodes are estimated as ComplexInfty
+     * @param onPath the nodes on the current dfs path (to detect cycles)
+     */
+    Complexity getPotentialComplexity(NodeIndex node, std::set<NodeIndex> &onPath);
+
+    /**
+     * Helper for getPotentialComplexity. Estimates the complexity of the given simple loop after acceleration.
+     * @param updateDegree is set to the factor by which the accelerated update might increase the degree of later costs
+     */
+    Complexity estimateAcceleratedComplexity(const Transition &loop, Complexity &updateDegree) const;
+
+    /**
+     * Returns the given nodes ordered by their optimistic complexity (most promising first),
+     * or in their natural order if GlobalFlags::costDirected is not set
+     */
+    std::vector<NodeIndex> orderByPotential(const std::set<NodeIndex> &nodeSet) const;
+
 private:
     NodeIndex initial;
     std::set<NodeIndex> nodes;
@@ -281,6 +401,19 @@ private:
     // accelerateSimpleLoops() uses the following set to communicate
     // with chainSimpleLoops().
     std::set<NodeIndex> addTransitionToSkipLoops;
+
+    // the state of an interrupted accelerateSimpleLoops() pass: the locations that still have to be processed
+    // (the first one might be partially processed, the resulting loops are stored in acceleratedLoops)
+    std::deque<NodeIndex> pendingAccelerations;
+    std::set<TransIndex> acceleratedLoops;
+
+    // the following members are only used for cost-directed exploration,
+    // potential is recomputed by computePotentials() at the start of each pass
+    std::map<NodeIndex,Complexity> potential;
+    RuntimeResult bestLowerBound;
+
+    // nodes whose elimination was already deferred by enforceBudget()
+    std::set<NodeIndex> deferredNodes;
 };
 
 #endif // FLOWGRAPH_H
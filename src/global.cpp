@@ -1,3 +1,5 @@
 #include "global.h"
 
 bool GlobalFlags::limitSmt = false;
+bool GlobalFlags::costDirected = false;
+int GlobalFlags::transitionBudget = TRANSITION_BUDGET;
@@ -39,6 +39,13 @@
  */
 #define CONTRACT_CHECK_EXP_OVER_UNKNOWN
 
+/*
+ * if defined, the models found by the SAT check before chaining are kept as witnesses for the guard
+ * of the resulting transition (at most this many per transition). When chaining this transition again,
+ * the new guard is first evaluated under these witnesses, which often proves SAT without calling z3.
+ */
+#define CONTRACT_WITNESS_POOL_SIZE 3
+
 /*
  * if defined, the number of transitions is heuristically recuded (see below)
  * after every branch contraction step (which usually creates many new transitions)
@@ -52,6 +59,24 @@
  */
 #define PRUNE_MAX_PARALLEL_TRANSITIONS 5
 
+/*
+ * default of the graph-wide budget for the number of transitions (can be enabled by --budget, 0 disables it)
+ * and for the total number of guard atoms (this factor times the transition budget).
+ * If eliminating a location would exceed the budget, the parallel transitions of this location are first merged
+ * (duplicates and subsumed transitions), then pruned by their syntactic complexity and finally the elimination
+ * of the location is deferred (once).
+ * NOTE: pruning loses precision, so the budget is disabled by default (bounded-memory mode only)
+ */
+#define TRANSITION_BUDGET 0
+#define GUARD_ATOM_BUDGET_FACTOR 20
+
+/*
+ * if defined, parallel transitions are removed if they are subsumed by another one, i.e., if the other transition
+ * has the same update, a weaker guard and at least the same cost. Guards are first compared syntactically,
+ * z3 is only used if at most this many atoms (or the cost comparison) remain to be shown.
+ */
+#define SUBSUMPTION_MAX_IMPLICATIONS 2
+
 /*
  * if defined, a preprocessing of the transition will always be performed before trying to meter a selfloop
  * NOTE: as the preprocessing is meant to be run rarely, this might have a performance impact
@@ -107,11 +132,72 @@
  */
 #define Z3_MAX_EXPONENT 5
 
+/*
+ * interval (in ms) in which the status file is rewritten (see --status)
+ */
+#define STATUS_INTERVAL_MS 1000
+
+/*
+ * if defined, z3 solvers are created for a specific logic (QF_LIA, QF_LRA, QF_NIA, QF_NRA), depending on
+ * the expressions translated in the solver's context so far (see Z3VariableContext::getLogic).
+ * NOTE: the solver's logic is fixed on construction, so the query should be translated before creating the solver
+ */
+#define Z3_LOGIC_SPECIFIC_SOLVERS
+
 /*
  * timeouts for z3 in ms
+ * NOTE: if Z3_FARKAS_TIMEOUT is not defined, the Farkas queries (for metering functions) have no timeout,
+ * as a timeout there loses metering functions (and thus results in worse bounds)
  */
 #define Z3_CHECK_TIMEOUT 100u
 #define Z3_LIMITSMT_TIMEOUT 500u
+//#define Z3_FARKAS_TIMEOUT 2000u
+
+/*
+ * if defined, the z3 timeout of each call site (see Z3Toolbox::CallSite) is adapted during the analysis:
+ * it is this factor times a (slowly decaying) estimate of the maximum latency of the decided (sat/unsat) calls
+ * of this site, limited to [base/4, 8*base] where base is the timeout above. So sites with fast results
+ * wait less for hopeless queries, while sites whose results arrive close to the timeout get more time.
+ * The timeouts are also limited to a fraction of the remaining time (see Z3_ADAPTIVE_BUDGET_FRACTION).
+ */
+#define Z3_ADAPTIVE_TIMEOUT 2
+#define Z3_ADAPTIVE_LATENCY_DECAY 0.95
+#define Z3_ADAPTIVE_BUDGET_FRACTION 20
+
+/*
+ * if defined, easy SAT checks (before chaining, for initial transitions and in the infinity check) are first
+ * tried by evaluating the guard on at most this many small integer points (see GuardSampler), before z3 is called.
+ * The points are first enumerated in the box [-SAMPLE_SAT_BOX,SAMPLE_SAT_BOX]^n (if small enough), then sampled randomly.
+ */
+#define SAMPLE_SAT_MAX_SAMPLES 256
+#define SAMPLE_SAT_BOX 2
+
+/*
+ * if defined, checkExpressionsSAT stores the unsat cores found by z3 (as sets of atom ids, at most this many).
+ * The core is obtained by a second check of unsat queries, with every atom tracked by an assumption literal. A query containing a known core is unsat without calling z3.
+ * If the cache is full or more than Z3_UNSAT_CORE_MAX_ATOMS atoms are known, all cores and atoms are dropped.
+ * NOTE: chained guards are often unsat due to a few conflicting atoms of a common prefix, so the cores are reused a lot
+ */
+#define Z3_UNSAT_CORE_CACHE 10000
+#define Z3_UNSAT_CORE_MAX_ATOMS 50000
+
+/*
+ * if defined, the rules of large input files are split into their parts using several threads
+ * (at most one thread per this many rules). The expressions are still parsed sequentially (GiNaC is not thread-safe).
+ */
+#define PARSER_PARALLEL_MIN_RULES 256
+
+/*
+ * if defined, Expression::expandMemo stores the expanded form of (non-atomic) expressions.
+ * If more than this many expressions are stored, the older half is dropped (the memo keeps two generations).
+ */
+#define EXPAND_MEMO_SIZE 4096
+
+/*
+ * the sparse polynomial kernel (see Polynomial) only handles exponents up to this bound,
+ * polynomials with larger exponents are left to GiNaC
+ */
+#define POLYNOMIAL_MAX_EXPONENT 64
 
 /*
  * if defined, the final guard/cost is checked to ensure it has infintily many instances
@@ -129,6 +215,8 @@
 //settings (can be specified on the command line)
 namespace GlobalFlags {
 extern bool limitSmt;
+extern bool costDirected;
+extern int transitionBudget;
 }
 
 
@@ -45,7 +45,7 @@ public:
      * @return the index of the added transition
      */
     TransIndex addTrans(NodeIndex from, NodeIndex to, T data) {
-        assert(check() == Valid);
+        assertParanoid(check() == Valid);
         TransIndex currIdx = nextIdx++;
         InternalTransition trans = {data,from,to};
 
@@ -54,7 +54,7 @@ public:
         transitions[currIdx] = std::move(trans);
         predecessor[to].insert(from);
         outgoing[from][to].push_back(currIdx);
-        assert(check() == Valid);
+        assertParanoid(check() == Valid);
         return currIdx;
     }
 
@@ -119,7 +119,7 @@ public:
      * (no new transition is added, data is kept)
      */
     void changeTransTarget(TransIndex trans, NodeIndex newTarget) {
-        assert(check() == Valid);
+        assertParanoid(check() == Valid);
         removeTransFromGraph(trans);
         InternalTransition &t = transitions[trans];
 
@@ -129,7 +129,7 @@ public:
         predecessor[newTarget].insert(t.from);
 
         t.to = newTarget;
-        assert(check() == Valid);
+        assertParanoid(check() == Valid);
     }
 
     /**
@@ -138,7 +138,7 @@ public:
      * @note afterwards, node has only incoming, newOutgoing only outgoing transitions
      */
     void splitNode(NodeIndex node, NodeIndex newOutgoing) {
-        assert(check() == Valid);
+        assertParanoid(check() == Valid);
         assert(outgoing.count(newOutgoing) == 0 && predecessor.count(newOutgoing) == 0);
 
         //move outgoing to new node
@@ -158,11 +158,11 @@ public:
         for (TransIndex idx : getTransFrom(newOutgoing)) {
             transitions[idx].from = newOutgoing;
         }
-        assert(check() == Valid);
+        assertParanoid(check() == Valid);
     }
 
     void removeNode(NodeIndex idx) {
-        assert(check() == Valid);
+        assertParanoid(check() == Valid);
         std::set<TransIndex> toRemove;
         //find outgoing transitions
         for (TransIndex out : getTransFrom(idx)) {
@@ -178,14 +178,14 @@ public:
         for (TransIndex idx : toRemove) removeTrans(idx);
         assert(outgoing.count(idx) == 0);
         assert(predecessor.count(idx) == 0);
-        assert(check() == Valid);
+        assertParanoid(check() == Valid);
     }
 
     void removeTrans(TransIndex idx) {
-        assert(check() == Valid);
+        assertParanoid(check() == Valid);
         removeTransFromGraph(idx);
         transitions.erase(idx);
-        assert(check() == Valid);
+        assertParanoid(check() == Valid);
     }
 
     enum CheckResult { Valid=0, InvalidNode, EmptyMapEntry, UnknownTrans, InvalidTrans, UnusedTrans, DuplicateTrans, InvalidPred, InvalidPredCount };
@@ -0,0 +1,207 @@
+/*  This file is part of LoAT.
+ *  Copyright (c) 2015-2016 Matthias Naaf, RWTH Aachen University, Germany
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses>.
+ */
+
+#include "guardsampler.h"
+
+#include <random>
+
+using namespace std;
+
+
+bool GuardSampler::findModel(const GuardList &guard, GiNaC::exmap &model) {
+#ifdef SAMPLE_SAT_MAX_SAMPLES
+    GuardSampler sampler(guard);
+    if (!sampler.compile()) return false;
+
+    const int n = sampler.vars.size();
+    sampler.point.assign(n,0);
+    int samples = 1;
+    if (sampler.isModel()) {
+        model = sampler.getModel();
+        return true;
+    }
+
+    //enumerate all points of the box [-B,B]^n if it is small enough
+    int boxSize = 1;
+    for (int i=0; i < n && boxSize <= SAMPLE_SAT_MAX_SAMPLES; ++i) boxSize *= 2*SAMPLE_SAT_BOX+1;
+
+    if (boxSize <= SAMPLE_SAT_MAX_SAMPLES) {
+        sampler.point.assign(n,-SAMPLE_SAT_BOX);
+        while (true) {
+            samples++;
+            if (sampler.isModel()) {
+                model = sampler.getModel();
+                return true;
+            }
+
+            //next point (odometer order)
+            int i = 0;
+            while (i < n && sampler.point[i] == SAMPLE_SAT_BOX) sampler.point[i++] = -SAMPLE_SAT_BOX;
+            if (i == n) break;
+            sampler.point[i]++;
+        }
+    }
+
+    //random points with a slowly growing radius (fixed seed for reproducible results)
+    mt19937 rng(42);
+    for (; samples < SAMPLE_SAT_MAX_SAMPLES; ++samples) {
+        int64_t radius = SAMPLE_SAT_BOX + samples/8;
+        uniform_int_distribution<int64_t> dist(-radius,radius);
+        for (int64_t &val : sampler.point) val = dist(rng);
+
+        if (sampler.isModel()) {
+            model = sampler.getModel();
+            return true;
+        }
+    }
+#endif
+    return false;
+}
+
+
+bool GuardSampler::compile() {
+    ExprSymbolSet symbols;
+    for (const Expression &ex : guard) ex.collectVariables(symbols);
+    vars.assign(symbols.begin(),symbols.end());
+
+    for (const Expression &ex : guard) {
+        Atom atom;
+        if (ex.info(GiNaC::info_flags::relation_equal)) atom.rel = Atom::Eq;
+        else if (ex.info(GiNaC::info_flags::relation_not_equal)) atom.rel = Atom::Neq;
+        else if (ex.info(GiNaC::info_flags::relation_less)) atom.rel = Atom::Less;
+        else if (ex.info(GiNaC::info_flags::relation_less_or_equal)) atom.rel = Atom::LessEq;
+        else if (ex.info(GiNaC::info_flags::relation_greater)) atom.rel = Atom::Greater;
+        else if (ex.info(GiNaC::info_flags::relation_greater_or_equal)) atom.rel = Atom::GreaterEq;
+        else return false;
+
+        if (!compileTerm(ex.lhs(),atom.code) || !compileTerm(ex.rhs(),atom.code)) return false;
+        atom.code.push_back({Instr::Const,-1});
+        atom.code.push_back({Instr::Mul,2});
+        atom.code.push_back({Instr::Add,2});
+        atoms.push_back(std::move(atom));
+    }
+    return true;
+}
+
+
+bool GuardSampler::compileTerm(const GiNaC::ex &term, vector<Instr> &code) {
+    if (GiNaC::is_a<GiNaC::add>(term) || GiNaC::is_a<GiNaC::mul>(term)) {
+        for (int i=0; i < term.nops(); ++i) {
+            if (!compileTerm(term.op(i),code)) return false;
+        }
+        code.push_back({GiNaC::is_a<GiNaC::add>(term) ? Instr::Add : Instr::Mul, (int64_t)term.nops()});
+        return true;
+    }
+    else if (GiNaC::is_a<GiNaC::power>(term)) {
+        if (!GiNaC::is_a<GiNaC::numeric>(term.op(1))) return false;
+        const GiNaC::numeric &exp = GiNaC::ex_to<GiNaC::numeric>(term.op(1));
+        if (!exp.is_nonneg_integer() || exp.int_length() > 8) return false;
+
+        if (!compileTerm(term.op(0),code)) return false;
+        code.push_back({Instr::Pow,exp.to_long()});
+        return true;
+    }
+    else if (GiNaC::is_a<GiNaC::numeric>(term)) {
+        const GiNaC::numeric &num = GiNaC::ex_to<GiNaC::numeric>(term);
+        if (!num.is_integer() || num.int_length() > 62) return false;
+        code.push_back({Instr::Const,num.to_long()});
+        return true;
+    }
+    else if (GiNaC::is_a<GiNaC::symbol>(term)) {
+        for (int i=0; i < vars.size(); ++i) {
+            if (term.is_equal(vars[i])) {
+                code.push_back({Instr::Var,i});
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+bool GuardSampler::evaluate(const Atom &atom, bool &overflow) {
+    stack.clear();
+    for (const Instr &instr : atom.code) {
+        switch (instr.op) {
+        case Instr::Const:
+            stack.push_back(instr.arg);
+            break;
+        case Instr::Var:
+            stack.push_back(point[instr.arg]);
+            break;
+        case Instr::Add:
+        case Instr::Mul: {
+            int64_t res = (instr.op == Instr::Add) ? 0 : 1;
+            for (int i=0; i < instr.arg; ++i) {
+                int64_t val = stack.back();
+                stack.pop_back();
+                if ((instr.op == Instr::Add) ? __builtin_add_overflow(res,val,&res) : __builtin_mul_overflow(res,val,&res)) {
+                    overflow = true;
+                    return false;
+                }
+            }
+            stack.push_back(res);
+            break;
+        }
+        case Instr::Pow: {
+            int64_t base = stack.back();
+            int64_t res = 1;
+            for (int64_t i=0; i < instr.arg; ++i) {
+                if (__builtin_mul_overflow(res,base,&res)) {
+                    overflow = true;
+                    return false;
+                }
+            }
+            stack.back() = res;
+            break;
+        }
+        }
+    }
+
+    assert(stack.size() == 1);
+    int64_t diff = stack.back();
+    switch (atom.rel) {
+        case Atom::Eq: return diff == 0;
+        case Atom::Neq: return diff != 0;
+        case Atom::Less: return diff < 0;
+        case Atom::LessEq: return diff <= 0;
+        case Atom::Greater: return diff > 0;
+        case Atom::GreaterEq: return diff >= 0;
+    }
+    return false;
+}
+
+
+bool GuardSampler::isModel() {
+    bool overflow = false;
+    for (const Atom &atom : atoms) {
+        if (!evaluate(atom,overflow)) {
+            //the machine integers are not precise enough, so use exact arithmetic instead
+            return overflow && GuardToolbox::isSatisfiedBy(guard,getModel());
+        }
+    }
+    return true;
+}
+
+
+GiNaC::exmap GuardSampler::getModel() const {
+    GiNaC::exmap model;
+    for (int i=0; i < vars.size(); ++i) {
+        model[vars[i]] = GiNaC::numeric((long)point[i]);
+    }
+    return model;
+}
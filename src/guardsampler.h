@@ -0,0 +1,86 @@
+/*  This file is part of LoAT.
+ *  Copyright (c) 2015-2016 Matthias Naaf, RWTH Aachen University, Germany
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses>.
+ */
+
+#ifndef GUARDSAMPLER_H
+#define GUARDSAMPLER_H
+
+#include "global.h"
+#include "expression.h"
+#include "guardtoolbox.h"
+
+#include <vector>
+#include <cstdint>
+
+
+/**
+ * Cheap search for an integer model of a guard, to avoid calling z3 for easy SAT checks.
+ * The guard is compiled into a flat postfix code over machine integers, which is then
+ * evaluated on small integer points (first exhaustively around 0, then randomly).
+ *
+ * @note this can only prove SAT, failing to find a model does not mean anything
+ */
+class GuardSampler {
+public:
+    /**
+     * Tries to find an integer model of the given guard by sampling (at most SAMPLE_SAT_MAX_SAMPLES points).
+     * @param model if a model is found, it is assigned the substitution of all symbols of the guard
+     * @return true iff a model was found (which is then guaranteed to satisfy the guard)
+     */
+    static bool findModel(const GuardList &guard, GiNaC::exmap &model);
+
+private:
+    struct Instr {
+        enum Op { Const, Var, Add, Mul, Pow } op;
+        int64_t arg; //value for Const, variable index for Var, number of operands for Add/Mul, exponent for Pow
+    };
+
+    struct Atom {
+        std::vector<Instr> code; //evaluates lhs-rhs
+        enum Rel { Eq, Neq, Less, LessEq, Greater, GreaterEq } rel;
+    };
+
+    GuardSampler(const GuardList &guard) : guard(guard) {}
+
+    /**
+     * Compiles the guard into atoms, returns false if this is not possible
+     * (e.g. for rational constants or non-polynomial terms)
+     */
+    bool compile();
+    bool compileTerm(const GiNaC::ex &term, std::vector<Instr> &code);
+
+    /**
+     * Evaluates the given atom for the current point
+     * @param overflow is set to true if the evaluation overflowed (the result is meaningless then)
+     */
+    bool evaluate(const Atom &atom, bool &overflow);
+
+    /**
+     * Checks if the current point is a model, using GiNaC as fallback if the machine integers overflow
+     */
+    bool isModel();
+
+    GiNaC::exmap getModel() const;
+
+private:
+    const GuardList &guard;
+    std::vector<Atom> atoms;
+    std::vector<ExprSymbol> vars;
+    std::vector<int64_t> point;
+    std::vector<int64_t> stack;
+};
+
+#endif // GUARDSAMPLER_H
@@ -32,6 +32,28 @@ bool GuardToolbox::isValidGuard(const GuardList &guard) {
 }
 
 
+bool GuardToolbox::isSatisfiedBy(const GuardList &guard, const GiNaC::exmap &witness) {
+    for (const Expression &ex : guard) {
+        GiNaC::ex diff = (ex.lhs() - ex.rhs()).subs(witness).expand();
+        if (!GiNaC::is_a<GiNaC::numeric>(diff)) return false;
+
+        const GiNaC::numeric &val = GiNaC::ex_to<GiNaC::numeric>(diff);
+        if (!val.is_real()) return false;
+
+        bool sat;
+        if (ex.info(GiNaC::info_flags::relation_equal)) sat = val.is_zero();
+        else if (ex.info(GiNaC::info_flags::relation_less)) sat = val.is_negative();
+        else if (ex.info(GiNaC::info_flags::relation_less_or_equal)) sat = !val.is_positive();
+        else if (ex.info(GiNaC::info_flags::relation_greater)) sat = val.is_positive();
+        else if (ex.info(GiNaC::info_flags::relation_greater_or_equal)) sat = !val.is_negative();
+        else sat = !val.is_zero();
+
+        if (!sat) return false;
+    }
+    return true;
+}
+
+
 bool GuardToolbox::isPolynomialGuard(const GuardList &guard, const GiNaC::lst &vars) {
     for (const Expression &ex : guard) {
         if (!ex.lhs().is_polynomial(vars) || !ex.rhs().is_polynomial(vars)) return false;
@@ -62,7 +84,7 @@ bool GuardToolbox::isNormalizedInequality(const Expression &term) {
 
 
 Expression GuardToolbox::replaceLhsRhs(const Expression &term, Expression lhs, Expression rhs) {
-    assert(isValidInequality(term));
+    assertAudit(isValidInequality(term));
     if (term.info(GiNaC::info_flags::relation_less)) return lhs < rhs;
     if (term.info(GiNaC::info_flags::relation_less_or_equal)) return lhs <= rhs;
     if (term.info(GiNaC::info_flags::relation_greater)) return lhs > rhs;
@@ -86,7 +108,7 @@ bool GuardToolbox::containsFreeVar(const ITRSProblem &itrs, const Expression &te
 
 
 Expression GuardToolbox::makeLessEqual(Expression term) {
-    assert(isValidInequality(term));
+    assertAudit(isValidInequality(term));
 
     //flip > or >=
     if (term.info(GiNaC::info_flags::relation_greater)) {
@@ -106,7 +128,7 @@ Expression GuardToolbox::makeLessEqual(Expression term) {
 
 
 Expression GuardToolbox::makeGreater(Expression term) {
-    assert(isValidInequality(term));
+    assertAudit(isValidInequality(term));
 
     //flip < or <=
     if (term.info(GiNaC::info_flags::relation_less)) {
@@ -126,12 +148,12 @@ Expression GuardToolbox::makeGreater(Expression term) {
 
 
 Expression GuardToolbox::normalize(Expression term) {
-    assert(isValidInequality(term));
+    assertAudit(isValidInequality(term));
 
     Expression greater = makeGreater(term);
     Expression normalized = (greater.lhs() - greater.rhs()) > 0;
 
-    assert(isNormalizedInequality(normalized));
+    assertAudit(isNormalizedInequality(normalized));
     return normalized;
 }
 
@@ -151,7 +173,7 @@ Expression GuardToolbox::turnToLess(Expression term) {
 
 
 Expression GuardToolbox::splitVariablesAndConstants(const Expression &term) {
-    assert(isValidInequality(term));
+    assertAudit(isValidInequality(term));
     assert(term.info(GiNaC::info_flags::relation_less_or_equal));
 
     //move everything to lhs
@@ -174,7 +196,7 @@ Expression GuardToolbox::splitVariablesAndConstants(const Expression &term) {
 
 
 Expression GuardToolbox::negateLessEqualInequality(const Expression &term) {
-    assert(isValidInequality(term));
+    assertAudit(isValidInequality(term));
     assert(term.info(GiNaC::info_flags::relation_less_or_equal));
     return (-term.lhs()) <= (-term.rhs())-1;
 }
@@ -101,6 +101,14 @@ namespace GuardToolbox {
     bool isValidGuard(const GuardList &guard);
 
 
+    /**
+     * Returns true iff the given assignment of numbers to symbols satisfies all guard terms
+     * @note returns false if some symbol of the guard is not assigned
+     * @note guard must be a valid guard
+     */
+    bool isSatisfiedBy(const GuardList &guard, const GiNaC::exmap &witness);
+
+
     /**
      * Returns true iff all guard terms have polynomial rhs and lhs
      * @note guard must be a valid guard
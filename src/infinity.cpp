@@ -20,6 +20,7 @@
 #include "timing.h"
 #include "z3toolbox.h"
 #include "guardtoolbox.h"
+#include "guardsampler.h"
 #include "flowgraph.h"
 #include "debug.h"
 
@@ -72,7 +73,7 @@ public:
     MonomData(const Expression &term, int varCount, const SymToIntFunc &func)
         : negative(false), varExp(varCount,0)
     {
-        Expression ex = term.expand();
+        Expression ex = term.expandMemo();
         if (is_a<mul>(ex)) {
             for (int i=0; i < ex.nops(); ++i) parseSubexpr(ex.op(i),func);
         } else {
@@ -257,7 +258,7 @@ void InfiniteInstances::dumpPolynoms() const {
 InfiniteInstances::PolynomData InfiniteInstances::parsePolynom(const Expression &term) const {
     auto symToInt = [&](const ExprSymbol &sym){ return symbolIndexMap.at(sym); };
     vector<MonomData> res;
-    Expression ex = term.expand();
+    Expression ex = term.expandMemo();
     if (is_a<add>(ex)) {
         for (int i=0; i < ex.nops(); ++i) res.push_back(MonomData(ex.op(i),getVarCount(),symToInt));
     } else {
@@ -472,7 +473,7 @@ void InfiniteInstances::removeEqualitiesFromGuard() {
 
     //find nonlinear substitutions, as they have an impact on the resulting runtime complexity
     for (const auto &it : equalSubs) {
-        assert(it.second.is_polynomial(itrs.getGinacVarList()));
+        assertAudit(it.second.is_polynomial(itrs.getGinacVarList()));
 
         //substituting (truly) free variables is ok
         string varname = GiNaC::ex_to<GiNaC::symbol>(it.first).get_name();
@@ -890,10 +891,11 @@ Expression InfiniteInstances::buildProofBound(const exmap &constSubs) const {
 
 InfiniteInstances::Result InfiniteInstances::check(const ITRSProblem &itrs, GuardList guard, Expression cost, bool isFinalCheck) {
     Timing::Scope timer(Timing::Infinity);
-    assert(GuardToolbox::isValidGuard(guard));
+    assertAudit(GuardToolbox::isValidGuard(guard));
 
-    //abort if there is no model at all
-    auto z3res = Z3Toolbox::checkExpressionsSAT(guard);
+    //abort if there is no model at all (try to find a model by sampling first, which is much cheaper)
+    GiNaC::exmap model;
+    auto z3res = GuardSampler::findModel(guard,model) ? z3::sat : Z3Toolbox::checkExpressionsSAT(guard);
     if (z3res == z3::unsat) return Result(Expression::ComplexNone,"unsat");
 
     //if cost is INF, a single model for the guard is sufficient
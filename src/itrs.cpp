@@ -21,10 +21,13 @@
 #include <sstream>
 #include <map>
 #include <cctype>
+#include <limits>
+#include <thread>
 
 #include <boost/algorithm/string.hpp>
 
 #include "z3toolbox.h"
+#include "binaryio.h"
 
 
 using namespace std;
@@ -126,28 +129,13 @@ void ITRSProblem::replaceUnboundedWithFresh(Expression &ex, GiNaC::exmap &unboun
 }
 
 /**
- * Parses a rule in the ITRS file format reading from line.
- * @param res the current state of the ITRS that is read (read and modified)
- * @param knownTerms mapping from string to the corresponding term index (read and modified)
- * @param knownVars mapping from string to the corresponding variable index (read and modified)
+ * Splits a rule in the ITRS file format into its parts, without parsing any expressions (first phase of parseRule).
+ * This only reads escapeSymbols and the settings, so it can be called for several rules in parallel.
  * @param line the input string
+ * @param res the parts of the rule (modified)
  */
-void ITRSProblem::parseRule(map<string,TermIndex> &knownTerms, map<string,VariableIndex> &knownVars, const string &line) {
-    debugParser("parsing rule: " << line);
-    Rule rule;
-    rule.cost = Expression(1); //default, if not specified
-
-    auto getTermIndex = [&](const string &s) -> TermIndex {
-        if (knownTerms.find(s) == knownTerms.end()) {
-            knownTerms[s] = this->terms.size();
-            this->terms.push_back(Term(s));
-        }
-        return knownTerms[s];
-    };
-
-    GiNaC::exmap unboundedSubs; //replace unbounded by fresh variables
-    GiNaC::exmap unifyArgSubs; //unify arguments across rules
-    ExprSymbolSet boundSymbols;
+void ITRSProblem::splitRule(const string &line, RuleStrings &res) const {
+    res.line = line;
 
     /* split string into lhs, rhs (and possibly cost in between) */
     string lhs,rhs,cost;
@@ -193,27 +181,137 @@ void ITRSProblem::parseRule(map<string,TermIndex> &knownTerms, map<string,Variab
         }
     }
 
+    /* lhs */
+    parseFunapp(lhs,res.lhsFun,res.lhsArgs);
+    for (string &v : res.lhsArgs) {
+        substituteVarnames(v);
+    }
+
+    /* rhs */
+    parseFunapp(rhs,res.rhsFun,res.rhsArgs);
+    for (string &v : res.rhsArgs) {
+        substituteVarnames(v);
+        if (!allowDivision && v.find('/') != string::npos) throw ITRSProblem::FileError("Divison is not allowed in the input");
+    }
+
+    /* cost */
+    if (!cost.empty()) {
+        substituteVarnames(cost);
+        if (!allowDivision && cost.find('/') != string::npos) throw ITRSProblem::FileError("Divison is not allowed in the input");
+        res.cost = cost;
+    }
+
+    /* guard */
+    if (!guard.empty()) {
+        string::size_type startpos = 0;
+        do {
+            pos = min(guard.find("/\\",startpos),guard.find("&&",startpos));
+            string term = guard.substr(startpos,(pos == string::npos) ? string::npos : (pos-startpos));
+            trim(term);
+            startpos = pos+2;
+            //ignore TRUE in guards (used to indicate an empty guard in some files)
+            if (term == "TRUE" || term.empty()) continue;
+            substituteVarnames(term);
+            if (term.find('/') != string::npos) throw ITRSProblem::FileError("Divison is not allowed in the input");
+            res.guard.push_back(std::move(term));
+        } while (pos != string::npos);
+    }
+}
+
+/**
+ * Splits all given rules (see splitRule), using several threads for large inputs.
+ * Errors are not thrown, but stored in the respective RuleStrings (so they are reported in rule order).
+ */
+void ITRSProblem::splitRules(const vector<string> &lines, vector<RuleStrings> &res) const {
+    res.assign(lines.size(),RuleStrings());
+
+    auto splitRange = [&](size_t first, size_t last) {
+        for (size_t i=first; i < last; ++i) {
+            try {
+                splitRule(lines[i],res[i]);
+            } catch (const FileError &err) {
+                res[i].error = err.what();
+            }
+        }
+    };
+
+    unsigned int threads = thread::hardware_concurrency();
+#ifdef PARSER_PARALLEL_MIN_RULES
+    threads = min<size_t>(threads, lines.size() / PARSER_PARALLEL_MIN_RULES);
+#else
+    threads = 1;
+#endif
+    if (threads <= 1) {
+        splitRange(0,lines.size());
+        return;
+    }
+
+    //every thread handles a contiguous block of rules
+    debugParser("splitting " << lines.size() << " rules using " << threads << " threads");
+    vector<thread> workers;
+    size_t blockSize = (lines.size() + threads - 1) / threads;
+    for (size_t first=0; first < lines.size(); first += blockSize) {
+        workers.emplace_back(splitRange, first, min(first+blockSize,lines.size()));
+    }
+    for (thread &t : workers) {
+        t.join();
+    }
+}
+
+/**
+ * Parses a rule in the ITRS file format reading from line.
+ * @param knownTerms mapping from string to the corresponding term index (read and modified)
+ * @param knownVars mapping from string to the corresponding variable index (read and modified)
+ * @param line the input string
+ */
+void ITRSProblem::parseRule(map<string,TermIndex> &knownTerms, map<string,VariableIndex> &knownVars, const string &line) {
+    RuleStrings parts;
+    splitRule(line,parts);
+    parseRule(knownTerms,knownVars,parts);
+}
+
+/**
+ * Parses the expressions of a rule that was split by splitRule and adds the rule to this ITRS.
+ * This registers terms and fresh variables, so the rules must be parsed in order (second phase of parseRule).
+ * @param knownTerms mapping from string to the corresponding term index (read and modified)
+ * @param knownVars mapping from string to the corresponding variable index (read and modified)
+ * @param parts the rule, as split by splitRule
+ */
+void ITRSProblem::parseRule(map<string,TermIndex> &knownTerms, map<string,VariableIndex> &knownVars, const RuleStrings &parts) {
+    debugParser("parsing rule: " << parts.line);
+    if (!parts.error.empty()) throw ITRSProblem::FileError(parts.error);
+
+    Rule rule;
+    rule.cost = Expression(1); //default, if not specified
+
+    auto getTermIndex = [&](const string &s) -> TermIndex {
+        if (knownTerms.find(s) == knownTerms.end()) {
+            knownTerms[s] = this->terms.size();
+            this->terms.push_back(Term(s));
+        }
+        return knownTerms[s];
+    };
+
+    GiNaC::exmap unboundedSubs; //replace unbounded by fresh variables
+    GiNaC::exmap unifyArgSubs; //unify arguments across rules
+    ExprSymbolSet boundSymbols;
 
     /* lhs */
-    string fun;
-    vector<string> args;
-    parseFunapp(lhs,fun,args);
     //parse variables
     vector<VariableIndex> argVars;
-    for (string &v : args) {
-        substituteVarnames(v);
+    for (const string &v : parts.lhsArgs) {
         auto it = knownVars.find(v);
         if (it == knownVars.end()) throw ITRSProblem::FileError("Unknown variable in lhs: " + v);
         argVars.push_back(it->second);
         boundSymbols.insert(getGinacSymbol(it->second));
     }
     //check if variable names differ from previous occurences and provide substitution if necessary
-    rule.lhsTerm = getTermIndex(fun);
+    rule.lhsTerm = getTermIndex(parts.lhsFun);
     if (this->terms[rule.lhsTerm].args.empty()) {
         this->terms[rule.lhsTerm].args = std::move(argVars);
     } else {
         if (this->terms[rule.lhsTerm].args.size() != argVars.size()) {
-            throw ITRSProblem::FileError("Funapp redeclared with different argument count: "+fun);
+            throw ITRSProblem::FileError("Funapp redeclared with different argument count: "+parts.lhsFun);
         }
         for (int i=0; i < argVars.size(); ++i) {
             VariableIndex vOld = this->terms[rule.lhsTerm].args[i];
@@ -222,52 +320,33 @@ void ITRSProblem::parseRule(map<string,TermIndex> &knownTerms, map<string,Variab
                 unifyArgSubs[getGinacSymbol(vNew)] = getGinacSymbol(vOld); //must be applied after renaming fresh variables
             }
         }
-        if (!unifyArgSubs.empty()) debugParser("ITRS Warning: funapp redeclared with different arguments: " << fun);
+        if (!unifyArgSubs.empty()) debugParser("ITRS Warning: funapp redeclared with different arguments: " << parts.lhsFun);
     }
 
     /* rhs */
-    args.clear();
-    ExprSymbolSet rhsSymbols;
-    parseFunapp(rhs,fun,args);
-    rule.rhsTerm = getTermIndex(fun);
-    for (string &v : args) {
-        substituteVarnames(v);
-        if (!allowDivision && v.find('/') != string::npos) throw ITRSProblem::FileError("Divison is not allowed in the input");
+    rule.rhsTerm = getTermIndex(parts.rhsFun);
+    for (const string &v : parts.rhsArgs) {
         Expression argterm = Expression::fromString(v,this->varSymbolList);
         replaceUnboundedWithFresh(argterm, unboundedSubs, boundSymbols);
         rule.rhsArgs.push_back(argterm.subs(unifyArgSubs));
     }
 
     /* cost */
-    if (!cost.empty()) {
-        substituteVarnames(cost);
-        if (!allowDivision && cost.find('/') != string::npos) throw ITRSProblem::FileError("Divison is not allowed in the input");
-        rule.cost = Expression::fromString(cost,this->varSymbolList);
+    if (!parts.cost.empty()) {
+        rule.cost = Expression::fromString(parts.cost,this->varSymbolList);
         if (!rule.cost.is_polynomial(this->varSymbolList)) throw ITRSProblem::FileError("Non polynomial cost in the input");
         replaceUnboundedWithFresh(rule.cost, unboundedSubs, boundSymbols);
         rule.cost = rule.cost.subs(unifyArgSubs);
     }
 
     /* guard */
-    ExprSymbolSet guardSymbols;
-    if (!guard.empty()) {
-        string::size_type startpos = 0;
-        do {
-            pos = min(guard.find("/\\",startpos),guard.find("&&",startpos));
-            string term = guard.substr(startpos,(pos == string::npos) ? string::npos : (pos-startpos));
-            trim(term);
-            startpos = pos+2;
-            //ignore TRUE in guards (used to indicate an empty guard in some files)
-            if (term == "TRUE" || term.empty()) continue;
-            substituteVarnames(term);
-            if (term.find('/') != string::npos) throw ITRSProblem::FileError("Divison is not allowed in the input");
-            Expression guardTerm = Expression::fromString(term,this->varSymbolList);
-            replaceUnboundedWithFresh(guardTerm, unboundedSubs, boundSymbols);
-            rule.guard.push_back(guardTerm.subs(unifyArgSubs));
-        } while (pos != string::npos);
+    for (const string &term : parts.guard) {
+        Expression guardTerm = Expression::fromString(term,this->varSymbolList);
+        replaceUnboundedWithFresh(guardTerm, unboundedSubs, boundSymbols);
+        rule.guard.push_back(guardTerm.subs(unifyArgSubs));
     }
     //ensure user given costs are positive
-    if (!cost.empty() && checkCosts) {
+    if (!parts.cost.empty() && checkCosts) {
         rule.guard.push_back(rule.cost >= 0);
     }
 
@@ -275,6 +354,9 @@ void ITRSProblem::parseRule(map<string,TermIndex> &knownTerms, map<string,Variab
 }
 
 
+static const string BINARY_MAGIC = "LoATitrs";
+static const int BINARY_VERSION = 1;
+
 ITRSProblem ITRSProblem::loadFromFile(const string &filename, bool allowDivision, bool checkCosts) {
     ITRSProblem res(allowDivision,checkCosts);
     string startTerm;
@@ -285,11 +367,23 @@ ITRSProblem ITRSProblem::loadFromFile(const string &filename, bool allowDivision
     if (!file.is_open())
         throw FileError("Unable to open file: "+filename);
 
+    //check if this is a file written by saveBinary
+    string magic(BINARY_MAGIC.size(),'\0');
+    if (file.read(&magic[0],magic.size()) && magic == BINARY_MAGIC) {
+        file.close();
+        ifstream binaryFile(filename, ios::binary);
+        return loadFromBinary(binaryFile,allowDivision,checkCosts);
+    }
+    file.clear();
+    file.seekg(0);
+
     bool has_vars, has_goal, has_start;
     has_vars = has_goal = has_start = false;
 
     bool in_rules = false;
+    vector<string> ruleLines;
 
+    //first phase: read the declarations and collect the rules
     string line;
     while (getline(file, line)) {
         trim(line);
@@ -299,7 +393,7 @@ ITRSProblem ITRSProblem::loadFromFile(const string &filename, bool allowDivision
             if (line == ")")
                 in_rules = false;
             else {
-                res.parseRule(knownTerms,knownVars,line);
+                ruleLines.push_back(line);
             }
         }
         else {
@@ -366,6 +460,14 @@ ITRSProblem ITRSProblem::loadFromFile(const string &filename, bool allowDivision
         }
     }
 
+    //second phase: split the rules (in parallel), then parse their expressions and register terms in rule order,
+    //so fresh variables are numbered deterministically (GiNaC is not thread-safe, so this is sequential)
+    vector<RuleStrings> ruleParts;
+    res.splitRules(ruleLines,ruleParts);
+    for (const RuleStrings &parts : ruleParts) {
+        res.parseRule(knownTerms,knownVars,parts);
+    }
+
     //ensure we have at least some rules
     if (res.rules.empty()) throw FileError("No rules defined");
 
@@ -394,6 +496,106 @@ ITRSProblem ITRSProblem::loadFromFile(const string &filename, bool allowDivision
 
 
 
+void ITRSProblem::saveBinary(ostream &s) const {
+    BinaryIO::writeHeader(s,BINARY_MAGIC,BINARY_VERSION);
+    BinaryIO::writeInt(s,allowDivision ? 1 : 0);
+    BinaryIO::writeInt(s,checkCosts ? 1 : 0);
+    saveVariables(s);
+
+    BinaryIO::writeInt(s,terms.size());
+    for (const Term &term : terms) {
+        BinaryIO::writeString(s,term.name);
+        BinaryIO::writeInt(s,term.args.size());
+        for (VariableIndex var : term.args) BinaryIO::writeInt(s,var);
+    }
+    BinaryIO::writeInt(s,startTerm);
+
+    //all expressions are collected in a single archive (written last), which also shares common subexpressions
+    GiNaC::archive ar;
+    BinaryIO::writeInt(s,rules.size());
+    for (const Rule &rule : rules) {
+        BinaryIO::writeInt(s,rule.lhsTerm);
+        BinaryIO::writeInt(s,rule.rhsTerm);
+        BinaryIO::writeInt(s,rule.rhsArgs.size());
+        BinaryIO::writeInt(s,rule.guard.size());
+        for (const Expression &ex : rule.rhsArgs) ar.archive_ex(ex,"arg");
+        for (const Expression &ex : rule.guard) ar.archive_ex(ex,"guard");
+        ar.archive_ex(rule.cost,"cost");
+    }
+    s << ar;
+}
+
+
+ITRSProblem ITRSProblem::loadFromBinary(istream &s, bool allowDivision, bool checkCosts) {
+    try {
+        BinaryIO::readHeader(s,BINARY_MAGIC,BINARY_VERSION);
+
+        //these options affect the parsing, so they cannot be changed for a compiled file
+        bool compiledAllowDivision = BinaryIO::readInt(s) != 0;
+        bool compiledCheckCosts = BinaryIO::readInt(s) != 0;
+        if (compiledAllowDivision != allowDivision) {
+            throw FileError(string("Compiled ITRS file was created ") + (compiledAllowDivision ? "with" : "without") + " --allow-division");
+        }
+        if (compiledCheckCosts != checkCosts) {
+            throw FileError(string("Compiled ITRS file was created ") + (compiledCheckCosts ? "without" : "with") + " --no-cost-check");
+        }
+
+        ITRSProblem res(allowDivision,checkCosts);
+        try {
+            res.loadVariables(s);
+        } catch (const FileError &) {
+            throw FileError("Invalid compiled ITRS file (variables)");
+        }
+
+        auto readIndex = [&](int max) {
+            int idx = BinaryIO::readInt(s);
+            if (idx < 0 || idx >= max) throw FileError("Invalid compiled ITRS file (index out of range)");
+            return idx;
+        };
+
+        int termCount = readIndex(numeric_limits<int>::max());
+        for (int i=0; i < termCount; ++i) {
+            res.terms.push_back(Term(BinaryIO::readString(s)));
+            for (int j=readIndex(numeric_limits<int>::max()); j > 0; --j) {
+                res.terms.back().args.push_back(readIndex(res.vars.size()));
+            }
+        }
+        res.startTerm = readIndex(termCount);
+
+        //the expressions are stored after the rule structure, so remember the sizes first
+        vector<pair<int,int>> sizes(readIndex(numeric_limits<int>::max()));
+        for (auto &size : sizes) {
+            Rule rule;
+            rule.lhsTerm = readIndex(termCount);
+            rule.rhsTerm = readIndex(termCount);
+            res.rules.push_back(rule);
+            size.first = readIndex(numeric_limits<int>::max());
+            size.second = readIndex(numeric_limits<int>::max());
+        }
+
+        GiNaC::archive ar;
+        if (!(s >> ar)) throw FileError("Invalid compiled ITRS file (unexpected end of file)");
+
+        unsigned nextExpr = 0;
+        auto readExpr = [&]() -> Expression {
+            if (nextExpr >= ar.num_expressions()) throw FileError("Invalid compiled ITRS file (missing expressions)");
+            return ar.unarchive_ex(res.varSymbolList,nextExpr++);
+        };
+        for (int i=0; i < res.rules.size(); ++i) {
+            Rule &rule = res.rules[i];
+            for (int j=0; j < sizes[i].first; ++j) rule.rhsArgs.push_back(readExpr());
+            for (int j=0; j < sizes[i].second; ++j) rule.guard.push_back(readExpr());
+            rule.cost = readExpr();
+        }
+
+        if (res.rules.empty()) throw FileError("No rules defined");
+        return res;
+    } catch (const BinaryIO::FormatError &e) {
+        throw FileError(string("Invalid compiled ITRS file: ") + e.what());
+    }
+}
+
+
 ITRSProblem ITRSProblem::dummyITRSforTesting(const vector<string> vars, const vector<string> &rules, bool allowDivision, bool checkCosts) {
     ITRSProblem res(allowDivision,checkCosts);
     map<string,TermIndex> knownTerms;
@@ -475,6 +677,33 @@ ExprSymbol ITRSProblem::getFreshSymbol(string basename) const {
 }
 
 
+void ITRSProblem::saveVariables(ostream &s) const {
+    BinaryIO::writeInt(s,vars.size());
+    for (VariableIndex i=0; i < vars.size(); ++i) {
+        BinaryIO::writeString(s,vars[i]);
+        BinaryIO::writeInt(s,isFreeVar(i) ? 1 : 0);
+    }
+}
+
+
+void ITRSProblem::loadVariables(istream &s) {
+    int count = BinaryIO::readInt(s);
+    if (count < vars.size()) throw FileError("Checkpoint does not match the input file (missing variables)");
+
+    for (VariableIndex i=0; i < count; ++i) {
+        string name = BinaryIO::readString(s);
+        bool free = BinaryIO::readInt(s) != 0;
+        if (i < vars.size()) {
+            //variables from the input file must match exactly
+            if (vars[i] != name) throw FileError("Checkpoint does not match the input file (variable " + name + ")");
+        } else {
+            addVariable(name);
+        }
+        if (free) freeVars.insert(i);
+    }
+}
+
+
 void ITRSProblem::print(ostream &s) const {
     auto printExpr = [&](const Expression &e) {
         s << e;
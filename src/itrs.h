@@ -23,6 +23,8 @@
 #include <vector>
 #include <string>
 #include <ostream>
+#include <algorithm>
+#include <stdexcept>
 
 #include <ginac/ginac.h>
 
@@ -34,7 +36,77 @@
 typedef int TermIndex;
 typedef int VariableIndex;
 typedef std::vector<Expression> GuardList;
-typedef std::map<VariableIndex,Expression> UpdateMap;
+
+
+/**
+ * Maps variables to their updated values, with the interface of std::map<VariableIndex,Expression>.
+ * Updates usually only affect a few variables, so the entries are stored in a vector sorted by the variable index,
+ * which is much cheaper to copy and iterate than a node-based map (the hot paths when chaining transitions).
+ */
+class UpdateMap {
+public:
+    typedef std::pair<VariableIndex,Expression> value_type;
+    typedef std::vector<value_type>::iterator iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    void clear() { entries.clear(); }
+    void reserve(size_t n) { entries.reserve(n); }
+
+    iterator find(VariableIndex var) {
+        iterator it = lowerBound(var);
+        return (it != entries.end() && it->first == var) ? it : entries.end();
+    }
+    const_iterator find(VariableIndex var) const {
+        return const_cast<UpdateMap*>(this)->find(var);
+    }
+    size_t count(VariableIndex var) const {
+        return (find(var) != end()) ? 1 : 0;
+    }
+
+    Expression& operator[](VariableIndex var) {
+        iterator it = lowerBound(var);
+        if (it == entries.end() || it->first != var) {
+            it = entries.emplace(it,var,Expression());
+        }
+        return it->second;
+    }
+    const Expression& at(VariableIndex var) const {
+        const_iterator it = find(var);
+        if (it == end()) throw std::out_of_range("UpdateMap::at");
+        return it->second;
+    }
+
+    size_t erase(VariableIndex var) {
+        iterator it = find(var);
+        if (it == entries.end()) return 0;
+        entries.erase(it);
+        return 1;
+    }
+
+    bool operator==(const UpdateMap &other) const {
+        return entries.size() == other.entries.size()
+            && std::equal(entries.begin(),entries.end(),other.entries.begin(),[](const value_type &a, const value_type &b) {
+                   return a.first == b.first && a.second.is_equal(b.second);
+               });
+    }
+
+private:
+    iterator lowerBound(VariableIndex var) {
+        return std::lower_bound(entries.begin(),entries.end(),var,[](const value_type &entry, VariableIndex v) {
+            return entry.first < v;
+        });
+    }
+
+private:
+    std::vector<value_type> entries;
+};
 
 
 /**
@@ -69,10 +141,17 @@ private:
 public:
     /**
      * Loads the ITRS data from the given file
+     * @note if the file was written by saveBinary, it is loaded without parsing (the flags must match the ones used for saveBinary)
      */
     static ITRSProblem loadFromFile(const std::string &filename, bool allowDivision = false, bool checkCosts = true);
     EXCEPTION(FileError,CustomException);
 
+    /**
+     * Writes the parsed ITRS in a compact binary format that can be loaded by loadFromFile,
+     * which avoids parsing the input again (the expressions are stored in a GiNaC archive)
+     */
+    void saveBinary(std::ostream &s) const;
+
     /**
      * Creates a dummy ITRSProblem that contains just the given rule
      * @note is not very robust and should _only_ be used for testing
@@ -109,6 +188,18 @@ public:
      */
     ExprSymbol getFreshSymbol(std::string basename) const;
 
+    /**
+     * Writes all variables (including fresh variables added during the analysis) in a binary format,
+     * used to save checkpoints (see FlowGraph::saveCheckpoint)
+     */
+    void saveVariables(std::ostream &s) const;
+
+    /**
+     * Restores the variables written by saveVariables, i.e. re-adds all fresh variables with their original names
+     * @note this itrs must have been loaded from the same file as the saved one, otherwise FileError is thrown
+     */
+    void loadVariables(std::istream &s);
+
     /**
      * Prints this ITRS contents in a readable but ugly format, for debugging only
      * @param s output stream to print to (e.g. cout)
@@ -116,6 +207,9 @@ public:
     void print(std::ostream &s) const;
 
 private:
+    //loads the format written by saveBinary, throws FileError if the file was compiled with different options
+    static ITRSProblem loadFromBinary(std::istream &s, bool allowDivision, bool checkCosts);
+
     //helpers for variable handling
     VariableIndex addVariable(std::string name);
     std::string getFreshName(std::string basename) const;
@@ -127,7 +221,22 @@ private:
     //ex is modified (substitution is applied) and unboundedSubs is extended if new unbound variables are encountered.
     void replaceUnboundedWithFresh(Expression &ex, GiNaC::exmap &unboundedSubs, const ExprSymbolSet &boundVars);
 
+    //a rule split into its parts (without parsing any expressions), variable names are already escaped
+    struct RuleStrings {
+        std::string line;
+        std::string lhsFun, rhsFun;
+        std::vector<std::string> lhsArgs, rhsArgs;
+        std::string cost; //empty if not specified
+        std::vector<std::string> guard;
+        std::string error; //set by splitRules if the rule is malformed
+    };
+
     //used internally by the (not very cleanly written) parser
+    void splitRule(const std::string &line, RuleStrings &res) const;
+    void splitRules(const std::vector<std::string> &lines, std::vector<RuleStrings> &res) const;
+    void parseRule(std::map<std::string,TermIndex> &knownTerms,
+                   std::map<std::string,VariableIndex> &knownVars,
+                   const RuleStrings &parts);
     void parseRule(std::map<std::string,TermIndex> &knownTerms,
                    std::map<std::string,VariableIndex> &knownVars,
                    const std::string &line);
@@ -0,0 +1,550 @@
+/*  This file is part of LoAT.
+ *  Copyright (c) 2015-2016 Matthias Naaf, RWTH Aachen University, Germany
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses>.
+ */
+
+/**
+ * Crash-isolating runner for large benchmark corpora (an alternative to benchscore.sh).
+ *
+ * The coordinator forks a pool of worker processes, each worker analyzes one problem at a time.
+ * Problems are sent to the workers over a pipe, the results are sent back over a second pipe.
+ * So a failed assertion or an abort in PURRS/z3 only affects a single problem, the crashed worker is replaced.
+ * Workers are also replaced after a given number of problems to limit the memory growth of GiNaC and z3.
+ * Every problem is analyzed with a limit on cpu time and memory (and a wall-clock limit enforced by the coordinator).
+ *
+ * The results are written as one JSON object per line (to stdout or the --results file), the progress
+ * and a summary (in the style of benchscore.sh) are printed to stderr, so the results can be parsed.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "itrs.h"
+#include "analysis.h"
+#include "stats.h"
+#include "timing.h"
+#include "timeout.h"
+
+using namespace std;
+
+
+struct RunnerSettings {
+    RunnerSettings() : workers(1), timeout(30), recycle(20), memLimit(4096) {}
+    int workers; //number of worker processes
+    int timeout; //timeout passed to LoAT (in seconds)
+    int recycle; //number of problems after which a worker is replaced
+    int memLimit; //address space limit of a worker (in MB)
+    string resultFile; //results are written to stdout if empty
+};
+
+/**
+ * A single worker process, as seen by the coordinator
+ */
+struct Worker {
+    pid_t pid;
+    int toWorker; //write end of the problem pipe
+    int fromWorker; //read end of the result pipe
+    int solved; //number of problems handled by this worker
+    bool busy;
+    bool killed; //true if killed by the coordinator due to the wall-clock limit
+    string problem; //the current problem
+    string buffer; //partial result line
+    chrono::steady_clock::time_point started;
+};
+
+
+/* ### Helpers ### */
+
+static bool writeAll(int fd, const string &str) {
+    size_t done = 0;
+    while (done < str.size()) {
+        ssize_t res = write(fd,str.data()+done,str.size()-done);
+        if (res < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += res;
+    }
+    return true;
+}
+
+static string jsonString(const string &str) {
+    stringstream ss;
+    ss << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') ss << '\\' << c;
+        else if (c == '\n') ss << "\\n";
+        else if (c == '\t') ss << "\\t";
+        else if ((unsigned char)c < 0x20) ss << ' ';
+        else ss << c;
+    }
+    ss << '"';
+    return ss.str();
+}
+
+//same output as "Complexity value" of LoAT, to be compatible with benchscore.sh
+static string complexityValue(const Complexity &cpx) {
+    if (cpx == Expression::ComplexInfty) return "INF";
+    if (cpx == Expression::ComplexNonterm) return "NONTERM";
+    if (cpx == Expression::ComplexExp || cpx == Expression::ComplexExpMore) return "EXP";
+    if (cpx == Expression::ComplexNone) return "none";
+    stringstream ss;
+    ss << cpx.val();
+    return ss.str();
+}
+
+//the score used by benchscore.sh
+static int complexityScore(const string &value) {
+    if (value == "INF" || value == "NONTERM") return 10000;
+    if (value == "EXP") return 1000;
+    return atoi(value.c_str());
+}
+
+static bool hasSuffix(const string &str, const string &suffix) {
+    return str.size() >= suffix.size() && str.compare(str.size()-suffix.size(),suffix.size(),suffix) == 0;
+}
+
+//recursively collects all .koat and .cint files
+static void collectProblems(const string &path, vector<string> &problems) {
+    struct stat st;
+    if (stat(path.c_str(),&st) != 0) {
+        cerr << "Warning: Unable to access: " << path << endl;
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        problems.push_back(path);
+        return;
+    }
+
+    DIR *dir = opendir(path.c_str());
+    if (!dir) return;
+    while (struct dirent *entry = readdir(dir)) {
+        string name = entry->d_name;
+        if (name == "." || name == "..") continue;
+        string sub = path + "/" + name;
+        if (stat(sub.c_str(),&st) != 0) continue;
+        if (S_ISDIR(st.st_mode)) {
+            collectProblems(sub,problems);
+        } else if (hasSuffix(name,".koat") || hasSuffix(name,".cint")) {
+            problems.push_back(sub);
+        }
+    }
+    closedir(dir);
+}
+
+
+/* ### Worker process ### */
+
+/**
+ * Analyzes a single problem, returns the complexity value (as printed by LoAT)
+ */
+static string analyzeProblem(const string &file, const RunnerSettings &settings) {
+    Stats::clear();
+    Timing::clear();
+    Timeout::setTimeouts(settings.timeout);
+
+    ITRSProblem itrs = ITRSProblem::loadFromFile(file);
+    AnalysisSettings analysisSettings;
+    analysisSettings.recordMemory = true; //reported as memory per step
+    int dotStep = 0;
+    RuntimeResult runtime = Analysis::run(itrs,analysisSettings,dotStep);
+    if (runtime.cpx == Expression::ComplexNone) runtime.cpx = 0; //the program is trivially empty
+    return complexityValue(runtime.cpx);
+}
+
+/**
+ * Main loop of a worker process. Reads problems (one per line) from in,
+ * writes one line "status \t value \t cpu time \t max rss \t memory per step (json)" per problem to out.
+ */
+static void workerLoop(int in, int out, const RunnerSettings &settings) {
+    //the proof output is not needed
+    int devnull = open("/dev/null",O_WRONLY);
+    if (devnull >= 0) {
+        dup2(devnull,STDOUT_FILENO);
+        dup2(devnull,STDERR_FILENO);
+        close(devnull);
+    }
+
+    //note that RLIMIT_RSS is not enforced by linux, so we limit the address space instead
+    struct rlimit mem;
+    mem.rlim_cur = mem.rlim_max = (rlim_t)settings.memLimit * 1024 * 1024;
+    setrlimit(RLIMIT_AS,&mem);
+
+    FILE *input = fdopen(in,"r");
+    char line[4096];
+    while (fgets(line,sizeof(line),input)) {
+        string file = line;
+        if (!file.empty() && file.back() == '\n') file.pop_back();
+
+        //the cpu limit applies to the whole process, so it has to be relative to the time used so far
+        struct rusage usage;
+        getrusage(RUSAGE_SELF,&usage);
+        long used = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec;
+        struct rlimit cpu;
+        getrlimit(RLIMIT_CPU,&cpu);
+        cpu.rlim_cur = used + settings.timeout + 5;
+        setrlimit(RLIMIT_CPU,&cpu);
+
+        string status = "ok";
+        string value;
+        bool outOfMemory = false;
+        try {
+            value = analyzeProblem(file,settings);
+        } catch (const CustomException &e) {
+            status = "error";
+            value = e.what();
+        } catch (const bad_alloc &) {
+            status = "memout";
+            outOfMemory = true;
+        }
+        replace(value.begin(),value.end(),'\t',' ');
+        replace(value.begin(),value.end(),'\n',' ');
+
+        getrusage(RUSAGE_SELF,&usage);
+        double cpuTime = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+                       + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+        stringstream res;
+        res << status << "\t" << value << "\t" << cpuTime << "\t" << usage.ru_maxrss << "\t";
+        Stats::printMemoryJson(res);
+        res << "\n";
+        if (!writeAll(out,res.str())) break;
+
+        //the state of GiNaC/z3 is not reliable after running out of memory
+        if (outOfMemory) break;
+    }
+    _exit(0);
+}
+
+
+/* ### Coordinator ### */
+
+class Coordinator {
+public:
+    Coordinator(const RunnerSettings &settings, ostream &results) : settings(settings), results(results) {}
+
+    void run(const vector<string> &problems);
+    void printSummary(ostream &s) const;
+
+private:
+    Worker spawnWorker();
+    void closePipes(Worker &worker);
+    void stopWorker(Worker &worker);
+    void finishProblem(Worker &worker, const string &status, const string &value, double cpuTime, long maxRss, const string &memory = "[]");
+
+    //handles a result line or the termination of the worker
+    void handleResult(Worker &worker, const string &line);
+    void handleCrash(Worker &worker);
+
+private:
+    const RunnerSettings &settings;
+    ostream &results;
+    vector<Worker> workers;
+
+    //summary
+    map<string,int> statusCount;
+    int score = 0;
+};
+
+
+void Coordinator::closePipes(Worker &worker) {
+    //the descriptors are reset, as their numbers are reused by the pipes of new workers
+    if (worker.toWorker >= 0) close(worker.toWorker);
+    if (worker.fromWorker >= 0) close(worker.fromWorker);
+    worker.toWorker = worker.fromWorker = -1;
+}
+
+
+Worker Coordinator::spawnWorker() {
+    int problemPipe[2], resultPipe[2];
+    if (pipe(problemPipe) != 0 || pipe(resultPipe) != 0) {
+        cerr << "Error: Unable to create pipes" << endl;
+        exit(1);
+    }
+
+    cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        cerr << "Error: Unable to fork worker" << endl;
+        exit(1);
+    }
+    if (pid == 0) {
+        //close the pipes of all other workers, otherwise they do not notice if the coordinator closes them
+        for (Worker &other : workers) {
+            closePipes(other);
+        }
+        close(problemPipe[1]);
+        close(resultPipe[0]);
+        workerLoop(problemPipe[0],resultPipe[1],settings);
+    }
+
+    close(problemPipe[0]);
+    close(resultPipe[1]);
+
+    Worker worker;
+    worker.pid = pid;
+    worker.toWorker = problemPipe[1];
+    worker.fromWorker = resultPipe[0];
+    worker.solved = 0;
+    worker.busy = false;
+    worker.killed = false;
+    return worker;
+}
+
+
+void Coordinator::stopWorker(Worker &worker) {
+    closePipes(worker);
+    int status;
+    waitpid(worker.pid,&status,0);
+}
+
+
+void Coordinator::finishProblem(Worker &worker, const string &status, const string &value, double cpuTime, long maxRss, const string &memory) {
+    double wallTime = chrono::duration<double>(chrono::steady_clock::now() - worker.started).count();
+
+    results << "{\"file\": " << jsonString(worker.problem)
+            << ", \"status\": " << jsonString(status)
+            << ", \"complexity\": " << jsonString(value)
+            << ", \"time\": " << wallTime
+            << ", \"cputime\": " << cpuTime
+            << ", \"maxrss_kb\": " << maxRss
+            << ", \"steps\": " << memory << "}" << endl;
+
+    statusCount[status]++;
+    if (status == "ok") score += complexityScore(value);
+    cerr << "[" << status << "] " << worker.problem << (status == "ok" ? ": " + value : "") << endl;
+
+    worker.busy = false;
+    worker.solved++;
+}
+
+
+void Coordinator::handleResult(Worker &worker, const string &line) {
+    stringstream ss(line);
+    string status, value, cpuTime, maxRss, memory;
+    getline(ss,status,'\t');
+    getline(ss,value,'\t');
+    getline(ss,cpuTime,'\t');
+    getline(ss,maxRss,'\t');
+    getline(ss,memory,'\t');
+    finishProblem(worker,status,value,atof(cpuTime.c_str()),atol(maxRss.c_str()),memory.empty() ? "[]" : memory);
+
+    //replace workers after some problems (or if they stopped themselves after running out of memory)
+    if (worker.solved >= settings.recycle || status == "memout") {
+        stopWorker(worker);
+        worker = spawnWorker();
+    }
+}
+
+
+void Coordinator::handleCrash(Worker &worker) {
+    closePipes(worker);
+    int status = 0;
+    waitpid(worker.pid,&status,0);
+
+    if (worker.busy) {
+        string reason;
+        if (worker.killed) reason = "timeout";
+        else if (WIFSIGNALED(status) && WTERMSIG(status) == SIGXCPU) reason = "cpulimit";
+        else reason = "crash";
+
+        string detail;
+        if (WIFSIGNALED(status)) detail = string("signal ") + strsignal(WTERMSIG(status));
+        else if (WIFEXITED(status)) detail = "exit code " + to_string(WEXITSTATUS(status));
+        finishProblem(worker,reason,detail,0,0);
+    }
+    worker = spawnWorker();
+}
+
+
+void Coordinator::run(const vector<string> &problems) {
+    for (int i=0; i < settings.workers; ++i) {
+        workers.push_back(spawnWorker());
+    }
+
+    //generous wall-clock limit, LoAT should stop by itself after the timeout
+    auto wallLimit = chrono::seconds(2*settings.timeout + 10);
+
+    size_t next = 0;
+    int running = 0;
+    while (next < problems.size() || running > 0) {
+        //hand out problems to idle workers
+        for (Worker &worker : workers) {
+            if (worker.busy || next >= problems.size()) continue;
+            worker.problem = problems[next++];
+            worker.busy = true;
+            worker.killed = false;
+            worker.buffer.clear();
+            worker.started = chrono::steady_clock::now();
+            running++;
+            if (!writeAll(worker.toWorker,worker.problem + "\n")) {
+                handleCrash(worker);
+                running--;
+            }
+        }
+
+        vector<pollfd> fds;
+        for (const Worker &worker : workers) {
+            fds.push_back({worker.fromWorker,POLLIN,0});
+        }
+        if (poll(fds.data(),fds.size(),1000) < 0 && errno != EINTR) {
+            cerr << "Error: poll failed" << endl;
+            exit(1);
+        }
+
+        for (int i=0; i < workers.size(); ++i) {
+            Worker &worker = workers[i];
+
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                char buf[4096];
+                ssize_t len = read(worker.fromWorker,buf,sizeof(buf));
+                if (len <= 0) {
+                    if (worker.busy) running--;
+                    handleCrash(worker);
+                    continue;
+                }
+                worker.buffer.append(buf,len);
+                size_t pos = worker.buffer.find('\n');
+                if (pos != string::npos) {
+                    string line = worker.buffer.substr(0,pos);
+                    worker.buffer.erase(0,pos+1);
+                    running--;
+                    handleResult(worker,line);
+                }
+            }
+
+            if (worker.busy && !worker.killed && chrono::steady_clock::now() - worker.started > wallLimit) {
+                kill(worker.pid,SIGKILL);
+                worker.killed = true;
+            }
+        }
+    }
+
+    for (Worker &worker : workers) {
+        stopWorker(worker);
+    }
+}
+
+
+void Coordinator::printSummary(ostream &s) const {
+    s << "===== Summary =====" << endl;
+    for (const auto &it : statusCount) {
+        s << "  " << it.first << ": " << it.second << endl;
+    }
+    s << "Total Score: " << score << endl;
+}
+
+
+void printHelp(char *arg0) {
+    cout << "Usage: " << arg0 << " [options] <files or directories>" << endl;
+    cout << "Analyzes all .koat and .cint files in parallel, each in an isolated worker process" << endl;
+    cout << "Options:" << endl;
+    cout << "  -j <num>           Number of worker processes (default: number of cores)" << endl;
+    cout << "  --timeout <sec>    Timeout per problem (in seconds), minimum: 10, default: 30" << endl;
+    cout << "  --recycle <num>    Replace workers after this number of problems (default: 20)" << endl;
+    cout << "  --mem-limit <mb>   Memory limit per worker (in MB, default: 4096)" << endl;
+    cout << "  --results <file>   Write the results (one JSON object per line) to the given file" << endl;
+    cout << "                     instead of stdout (progress and summary are printed to stderr)" << endl;
+}
+
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printHelp(argv[0]);
+        return 1;
+    }
+
+    RunnerSettings settings;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores > 0) settings.workers = cores;
+    vector<string> paths;
+
+    int arg=0;
+    while (++arg < argc) {
+        if (strcmp("--help",argv[arg]) == 0) {
+            printHelp(argv[0]);
+            return 1;
+        } else if (strcmp("-j",argv[arg]) == 0) {
+            assert(arg < argc-1);
+            settings.workers = atoi(argv[++arg]);
+        } else if (strcmp("--timeout",argv[arg]) == 0) {
+            assert(arg < argc-1);
+            settings.timeout = atoi(argv[++arg]);
+        } else if (strcmp("--recycle",argv[arg]) == 0) {
+            assert(arg < argc-1);
+            settings.recycle = atoi(argv[++arg]);
+        } else if (strcmp("--mem-limit",argv[arg]) == 0) {
+            assert(arg < argc-1);
+            settings.memLimit = atoi(argv[++arg]);
+        } else if (strcmp("--results",argv[arg]) == 0) {
+            assert(arg < argc-1);
+            settings.resultFile = argv[++arg];
+        } else {
+            paths.push_back(argv[arg]);
+        }
+    }
+    if (settings.timeout < 10) {
+        cout << "Error: timeout must be at least 10 seconds" << endl;
+        return 1;
+    }
+    if (settings.workers < 1 || settings.recycle < 1 || settings.memLimit < 1) {
+        cout << "Error: invalid number of workers, problems or memory limit" << endl;
+        return 1;
+    }
+
+    vector<string> problems;
+    for (const string &path : paths) {
+        collectProblems(path,problems);
+    }
+    sort(problems.begin(),problems.end());
+    if (problems.empty()) {
+        cout << "Error: no problems found" << endl;
+        return 1;
+    }
+
+    ofstream resultStream;
+    if (!settings.resultFile.empty()) {
+        resultStream.open(settings.resultFile);
+        if (!resultStream.is_open()) {
+            cout << "Error: Unable to open file: " << settings.resultFile << endl;
+            return 1;
+        }
+    }
+
+    //a crashed worker must not kill the coordinator
+    signal(SIGPIPE,SIG_IGN);
+
+    cerr << "Analyzing " << problems.size() << " problems with " << settings.workers << " workers" << endl;
+    Coordinator coordinator(settings, settings.resultFile.empty() ? cout : resultStream);
+    coordinator.run(problems);
+    coordinator.printSummary(cerr);
+    return 0;
+}
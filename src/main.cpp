@@ -25,14 +25,21 @@
 
 #include <sstream>
 #include <fstream>
+#include <iomanip>
+
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
 
 using namespace std;
 
 
 #include "itrs.h"
 #include "flowgraph.h"
+#include "analysis.h"
 #include "preprocess.h"
 #include "stats.h"
+#include "status.h"
 #include "timing.h"
 #include "timeout.h"
 
@@ -121,7 +128,297 @@ void printHelp(char *arg0) {
     cout << "                     Note: LoAT is not sound for division in general" << endl;
     cout << "  --no-cost-check    Don't check if costs are nonnegative (potentially unsound)" << endl;
     cout << "  --no-preprocessing Don't try to simplify the program first (involves SMT)" << endl;
+    cout << "  --no-pruning       Don't prune parallel transitions (and don't apply --budget)" << endl;
     cout << "  --limit-smt        Solve limit problems by SMT queries when applicable" << endl;
+    cout << "  --cost-directed    Explore the most promising paths first and skip paths" << endl;
+    cout << "                     that cannot improve the best lower bound found so far" << endl;
+    cout << "  --compile <file>   Save the parsed input in a binary format (which can be" << endl;
+    cout << "                     given as input file to skip parsing) and exit" << endl;
+    cout << "  --checkpoint <file>" << endl;
+    cout << "                     Save the analysis state to the given file after every step" << endl;
+    cout << "  --resume <file>    Continue the analysis from the given checkpoint (and update it)" << endl;
+    cout << "                     Note: <file> must be the same input file as for the checkpoint" << endl;
+    cout << "  --budget <n>       Bounded-memory mode: keep the graph at about n transitions by pruning" << endl;
+    cout << "                     or deferring locations whose elimination exceeds it (default: off)" << endl;
+    cout << "                     Note: pruning loses precision, so the results might get worse" << endl;
+    cout << "  --portfolio        Run several variants (limit-smt, no-pruning, no-preprocessing)" << endl;
+    cout << "                     in parallel processes and print the proof with the best result" << endl;
+    cout << "  --status <file>    Periodically write the current status (pass, location, active" << endl;
+    cout << "                     z3/purrs call, best bound so far) as json object to the given file" << endl;
+}
+
+
+/**
+ * Runs the analysis for the given settings and prints the proof and the resulting complexity
+ * @param dotStream if not null, the final dot subgraph is printed to it (and the stream is closed)
+ * @return the exit code for main
+ */
+int analyze(ITRSProblem &itrs, const AnalysisSettings &settings, int &dotStep, ofstream *dotStream,
+            bool printStats, bool printTiming, RuntimeResult &runtime) {
+    try {
+        runtime = Analysis::run(itrs,settings,dotStep);
+    } catch (const ITRSProblem::FileError &e) {
+        cout << "Error: " << e.what() << endl;
+        return 1;
+    }
+    Timing::done(Timing::Total);
+    Status::stop();
+
+    // ### Some nice proof output ###
+
+    proofout << endl;
+    proofout << "The final runtime is determined by this resulting transition:" << endl;
+    proofout << "  Final Guard: ";
+    for (int i=0; i < runtime.guard.size(); ++i) { if (i > 0) proofout << " && "; proofout << runtime.guard.at(i); }
+    proofout << endl;
+    proofout << "  Final Cost:  " << runtime.bound << endl;
+    proofout << endl;
+
+    if (runtime.reducedCpx) {
+        proofout << "Note that the variables in this cost term are only a sublinear fraction" << endl;
+        proofout << "of the input length n, so the complexity had to be reduced." << endl << endl;
+    }
+
+    proofout << "Obtained the following complexity w.r.t. the length of the input n:" << endl;
+    proofout << "  Complexity class: " << Expression::complexityString(runtime.cpx) << endl;
+    proofout << "  Complexity value: ";
+    {
+        if (runtime.cpx == Expression::ComplexInfty) proofout << "INF" << endl;
+        else if (runtime.cpx == Expression::ComplexNonterm) proofout << "NONTERM" << endl;
+        else if (runtime.cpx == Expression::ComplexExp) proofout << "EXP" << endl;
+        else if (runtime.cpx == Expression::ComplexExpMore) proofout << "EXP" << endl;
+        else if (runtime.cpx == Expression::ComplexNone) proofout << "none" << endl;
+        else proofout << runtime.cpx.val() << endl;
+    }
+
+#ifndef DEBUG_DISABLE_ALL
+    cout << "DEBUG Bound: " << runtime.bound << endl;
+    cout << "DEBUG Complexity value: ";
+    {
+        if (runtime.cpx == Expression::ComplexInfty) cout << "INF" << endl;
+        else if (runtime.cpx == Expression::ComplexNonterm) cout << "NONTERM" << endl;
+        else if (runtime.cpx == Expression::ComplexExp) cout << "EXP" << endl;
+        else if (runtime.cpx == Expression::ComplexExpMore) cout << "EXP" << endl;
+        else if (runtime.cpx == Expression::ComplexNone) proofout << "none" << endl;
+        else cout << runtime.cpx.val() << endl;
+    }
+#endif
+
+    if (dotStream) {
+        FlowGraph::printDotText(*dotStream,dotStep++,Expression::complexityString(runtime.cpx));
+        *dotStream << "}" << endl;
+        dotStream->close();
+    }
+
+    if (printStats) {
+        cout << endl;
+        Stats::print(cout);
+    }
+
+    if (printTiming) {
+        cout << endl;
+        Timing::print(cout);
+    }
+
+    if (runtime.cpx == Expression::ComplexNonterm) {
+        proofout << endl << "NO" << endl;
+    } else {
+        proofout << endl << "WORST_CASE(";
+        if (runtime.cpx == Expression::ComplexInfty) proofout << "INF";
+        else if (runtime.cpx == Expression::ComplexExp) proofout << "EXP";
+        else if (runtime.cpx == Expression::ComplexExpMore) proofout << "EXP";
+        else if (runtime.cpx == Expression::ComplexNone) proofout << "Omega(0)";
+        else if (runtime.cpx == 0) proofout << "Omega(1)";
+        else proofout << "Omega(n^" << runtime.cpx << ")";
+        proofout << ",?)" << endl;
+    }
+
+    return 0;
+}
+
+
+/**
+ * A pipeline variant for --portfolio, applied on top of the options given on the command line
+ */
+struct PortfolioVariant {
+    const char *name;
+    bool limitSmt; //enables --limit-smt
+    bool noPreprocessing; //enables --no-preprocessing
+    bool noPruning; //enables --no-pruning (and disables the transition budget)
+};
+
+static const PortfolioVariant portfolioVariants[] = {
+    { "default", false, false, false },
+    { "limit-smt", true, false, false },
+    { "no-pruning", false, false, true },
+    { "no-preprocessing", false, true, false },
+};
+
+
+/**
+ * Runs the variants of portfolioVariants in forked processes (at most one per core) and prints the proof
+ * of the variant with the best complexity. The variants share the timeout (which is set before forking),
+ * all variants are killed once a variant proves unbounded runtime (or when the hard timeout is reached).
+ * @return the exit code for main
+ */
+int runPortfolio(ITRSProblem &itrs, const AnalysisSettings &baseSettings, bool printStats, bool printTiming) {
+    struct Job {
+        const PortfolioVariant *variant;
+        AnalysisSettings settings;
+        bool limitSmt;
+        int budget;
+        pid_t pid;
+        FILE *output; //the output of the variant (i.e. its proof)
+        int resultPipe; //the variant writes its complexity (as value) to this pipe
+        bool running;
+        bool hasResult;
+        double cpx;
+    };
+
+    //skip variants that coincide with previous ones (e.g. if --limit-smt was already given)
+    vector<Job> jobs;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    for (const PortfolioVariant &variant : portfolioVariants) {
+        if (jobs.size() >= max(cores,1L)) break;
+
+        Job job;
+        job.variant = &variant;
+        job.settings = baseSettings;
+        job.settings.doPreprocessing = baseSettings.doPreprocessing && !variant.noPreprocessing;
+        job.settings.doPruning = baseSettings.doPruning && !variant.noPruning;
+        job.limitSmt = GlobalFlags::limitSmt || variant.limitSmt;
+        job.budget = variant.noPruning ? 0 : GlobalFlags::transitionBudget;
+
+        bool known = false;
+        for (const Job &other : jobs) {
+            known = known || (other.settings.doPreprocessing == job.settings.doPreprocessing
+                              && other.settings.doPruning == job.settings.doPruning
+                              && other.limitSmt == job.limitSmt && other.budget == job.budget);
+        }
+        if (!known) jobs.push_back(job);
+    }
+
+    cout << "Portfolio: running " << jobs.size() << " variants:";
+    for (const Job &job : jobs) cout << " " << job.variant->name;
+    cout << endl;
+
+    auto killRunning = [&]() {
+        for (const Job &job : jobs) {
+            if (job.running) kill(job.pid,SIGKILL);
+        }
+    };
+
+    //the output must be flushed, otherwise it is printed by every child as well
+    cout.flush();
+    fflush(stdout);
+
+    for (Job &job : jobs) {
+        job.running = false;
+        job.hasResult = false;
+        job.output = tmpfile();
+
+        int fds[2];
+        if (!job.output || pipe(fds) != 0) {
+            cout << "Error: Unable to start portfolio variant " << job.variant->name << endl;
+            killRunning();
+            return 1;
+        }
+
+        job.pid = fork();
+        if (job.pid == 0) {
+            //child: run the analysis with the output redirected to the temporary file
+            close(fds[0]);
+            dup2(fileno(job.output),STDOUT_FILENO);
+            GlobalFlags::limitSmt = job.limitSmt;
+            GlobalFlags::transitionBudget = job.budget;
+
+            int dotStep = 0;
+            RuntimeResult runtime;
+            int res = analyze(itrs,job.settings,dotStep,nullptr,printStats,printTiming,runtime);
+            cout.flush();
+            fflush(stdout);
+
+            if (res == 0) {
+                ostringstream msg;
+                msg << setprecision(17) << runtime.cpx.val();
+                string str = msg.str();
+                if (write(fds[1],str.c_str(),str.size()) < 0) res = 1;
+            }
+            close(fds[1]);
+            _exit(res);
+        }
+
+        close(fds[1]);
+        job.resultPipe = fds[0];
+        if (job.pid < 0) {
+            cout << "Error: Unable to start portfolio variant " << job.variant->name << endl;
+            killRunning();
+            return 1;
+        }
+        job.running = true;
+    }
+
+    //wait for the variants, stop early if unbounded runtime was proven
+    size_t running = jobs.size();
+    bool killed = false;
+    while (running > 0) {
+        int status;
+        pid_t pid = waitpid(-1,&status,WNOHANG);
+        if (pid < 0) break;
+
+        if (pid == 0) {
+            if (!killed && Timeout::hard()) {
+                killRunning();
+                killed = true;
+            }
+            usleep(10000);
+            continue;
+        }
+
+        for (Job &job : jobs) {
+            if (job.pid != pid) continue;
+            job.running = false;
+            running--;
+
+            char buf[64];
+            ssize_t len = read(job.resultPipe,buf,sizeof(buf)-1);
+            if (len > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                buf[len] = '\0';
+                job.cpx = strtod(buf,nullptr);
+                job.hasResult = true;
+            }
+            close(job.resultPipe);
+
+            if (!killed && job.hasResult && job.cpx >= Expression::ComplexInfty.val()) {
+                killRunning();
+                killed = true;
+            }
+        }
+    }
+
+    //pick the best variant (the first one in case of equal complexity)
+    const Job *best = nullptr;
+    for (const Job &job : jobs) {
+        if (job.hasResult && (!best || job.cpx > best->cpx)) best = &job;
+    }
+
+    int exitCode = 1;
+    if (best) {
+        cout << "Portfolio: using the proof of variant " << best->variant->name << endl << endl;
+        rewind(best->output);
+        char buf[4096];
+        size_t len;
+        while ((len = fread(buf,1,sizeof(buf),best->output)) > 0) {
+            fwrite(buf,1,len,stdout);
+        }
+        fflush(stdout);
+        exitCode = 0;
+    } else {
+        cout << "Error: No portfolio variant finished successfully" << endl;
+    }
+
+    for (const Job &job : jobs) fclose(job.output);
+    return exitCode;
 }
 
 
@@ -140,7 +437,15 @@ int main(int argc, char *argv[]) {
     bool allowDivision = false;
     bool checkCosts = true;
     bool doPreprocessing = true;
+    bool doPruning = true;
+    bool portfolio = false;
     bool limitSmtSolving = false;
+    bool costDirected = false;
+    int budget = TRANSITION_BUDGET;
+    string compileFile;
+    string checkpointFile;
+    string resumeFile;
+    string statusFile;
     string filename;
     int timeout = 0;
 
@@ -174,8 +479,29 @@ int main(int argc, char *argv[]) {
             doPreprocessing = false;
         } else if (strcmp("--no-cost-check",argv[arg]) == 0) {
             checkCosts = false;
+        } else if (strcmp("--no-pruning",argv[arg]) == 0) {
+            doPruning = false;
+        } else if (strcmp("--portfolio",argv[arg]) == 0) {
+            portfolio = true;
         } else if (strcmp("--limit-smt",argv[arg]) == 0) {
             limitSmtSolving = true;
+        } else if (strcmp("--cost-directed",argv[arg]) == 0) {
+            costDirected = true;
+        } else if (strcmp("--budget",argv[arg]) == 0) {
+            assert(arg < argc-1);
+            budget = atoi(argv[++arg]);
+        } else if (strcmp("--compile",argv[arg]) == 0) {
+            assert(arg < argc-1);
+            compileFile = argv[++arg];
+        } else if (strcmp("--checkpoint",argv[arg]) == 0) {
+            assert(arg < argc-1);
+            checkpointFile = argv[++arg];
+        } else if (strcmp("--resume",argv[arg]) == 0) {
+            assert(arg < argc-1);
+            resumeFile = argv[++arg];
+        } else if (strcmp("--status",argv[arg]) == 0) {
+            assert(arg < argc-1);
+            statusFile = argv[++arg];
         } else {
             if (!filename.empty()) {
                 cout << "Error: additional argument " << argv[arg] << " (already got filenam: " << filename << ")" << endl;
@@ -195,6 +521,13 @@ int main(int argc, char *argv[]) {
     if (timeout > 0) {
         Timeout::setTimeouts(timeout);
     }
+    if (portfolio && (dotOutput || !checkpointFile.empty() || !resumeFile.empty() || !statusFile.empty())) {
+        cout << "Error: --portfolio cannot be combined with --dot, --checkpoint, --resume or --status" << endl;
+        return 1;
+    }
+    if (!resumeFile.empty() && checkpointFile.empty()) {
+        checkpointFile = resumeFile;
+    }
 
     if (allowDivision) {
         cout << endl << "WARNING: Allowing division in the input program can yield unsound results!" << endl;
@@ -207,6 +540,8 @@ int main(int argc, char *argv[]) {
     }
 
     GlobalFlags::limitSmt = limitSmtSolving;
+    GlobalFlags::costDirected = costDirected;
+    GlobalFlags::transitionBudget = doPruning ? budget : 0;
 
     // ### Start analyzing ###
 
@@ -222,192 +557,42 @@ int main(int argc, char *argv[]) {
         dotStream << "digraph {" << endl;
     }
 
+    if (!statusFile.empty()) {
+        Status::start(statusFile);
+        Status::setPass("Loading");
+    }
+
     Timing::start(Timing::Total);
     cout << "Trying to load file: " << filename << endl;
 
     ITRSProblem res = ITRSProblem::loadFromFile(filename,allowDivision,checkCosts);
-    FlowGraph g(res);
-
-    proofout << endl << "Initial Control flow graph problem:" << endl;
-    g.printForProof();
-    if (dotOutput) g.printDot(dotStream,dotStep++,"Initial");
 
-    if (g.reduceInitialTransitions()) {
-        proofout << endl << "Removed unsatisfiable initial transitions:" << endl;
-        g.printForProof();
-        if (dotOutput) g.printDot(dotStream,dotStep++,"Reduced initial");
-    }
-
-    RuntimeResult runtime;
-    if (!g.isEmpty()) {
-        //do some preprocessing
-        if (doPreprocessing) {
-            if (g.preprocessTransitions(checkCosts)) {
-                proofout << endl <<  "Simplified the transitions:" << endl;
-                g.printForProof();
-                if (dotOutput) g.printDot(dotStream,dotStep++,"Simplify");
-            }
-        }
-
-        while (!g.isFullyChained()) {
-
-            bool changed;
-            do {
-                changed = false;
-
-                if (g.accelerateSimpleLoops()) {
-                    changed = true;
-                    proofout << endl <<  "Accelerated all simple loops using metering functions"
-                             << " (where possible):" << endl;
-                    g.printForProof();
-                    if (dotOutput) g.printDot(dotStream,dotStep++,"Accelerate simple loops");
-                }
-                if (Timeout::soft()) break;
-
-                if (g.chainSimpleLoops()) {
-                    changed = true;
-                    proofout << endl <<  "Chained simpled loops:" << endl;
-                    g.printForProof();
-                    if (dotOutput) g.printDot(dotStream,dotStep++,"Chain simple loops");
-                }
-                if (Timeout::soft()) break;
-
-                if (g.chainLinear()) {
-                    changed = true;
-                    proofout << endl <<  "Eliminated locations (linear):" << endl;
-                    g.printForProof();
-                    if (dotOutput) g.printDot(dotStream,dotStep++,"Eliminate Locations (linear)");
-                }
-                if (Timeout::soft()) break;
-
-            } while (changed);
-
-
-            if (g.chainBranches()) {
-                proofout << endl <<  "Eliminated locations (branches):" << endl;
-                g.printForProof();
-                if (dotOutput) g.printDot(dotStream,dotStep++,"Eliminate Locations (branches)");
-
-            } else if (g.eliminateALocation()) {
-                proofout << endl <<  "Eliminated locations:" << endl;
-                g.printForProof();
-                if (dotOutput) g.printDot(dotStream,dotStep++,"Eliminate Locations");
-            }
-            if (Timeout::soft()) break;
-
-            if (g.pruneTransitions()) {
-                proofout << endl <<  "Pruned:" << endl;
-                g.printForProof();
-                if (dotOutput) { g.printDot(dotStream,dotStep++,"Prune"); }
-            }
-            if (Timeout::soft()) break;
-        }
-
-        if (Timeout::soft()) proofout << "Aborted due to lack of remaining time" << endl << endl;
-
-        //simplify the simplified program
-        if (g.isFullyChained()) {
-            g.removeDuplicateInitialTransitions();
-        }
-
-        proofout << endl << "Final control flow graph problem, now checking costs for infinitely many models:" << endl;
-        g.printForProof();
-        if (dotOutput) g.printDot(dotStream,dotStep++,"Final");
-
-        if (printSimplified) {
-            proofout << endl << "Simplified program in input format:" << endl;
-            g.printKoAT();
-            proofout << endl;
-        }
-
-        if (!g.isFullyChained()) {
-            //handling for timeouts
-            proofout << "This is only a partial result (probably due to a timeout), trying to find max complexity" << endl << endl;
-            runtime = g.getMaxPartialResult();
-        } else {
-            //no timeout, fully contracted, find maximum runtime
-            proofout << endl;
-            runtime = g.getMaxRuntime();
-        }
-
-        //if we failed to prove a bound, we can still output O(1) with bound 1, as the graph was non-empty
-        if (runtime.cpx == Expression::ComplexNone) {
-            runtime.cpx = 0;
-            runtime.bound = Expression(1);
-            runtime.guard.clear();
+    if (!compileFile.empty()) {
+        ofstream compileStream(compileFile, ios::binary);
+        if (!compileStream.is_open()) {
+            cout << "Error: Unable to open file: " << compileFile << endl;
+            return 1;
         }
+        res.saveBinary(compileStream);
+        cout << "Saved binary input to: " << compileFile << endl;
+        return 0;
     }
-    Timing::done(Timing::Total);
-
-    // ### Some nice proof output ###
 
-    proofout << endl;
-    proofout << "The final runtime is determined by this resulting transition:" << endl;
-    proofout << "  Final Guard: ";
-    for (int i=0; i < runtime.guard.size(); ++i) { if (i > 0) proofout << " && "; proofout << runtime.guard.at(i); }
-    proofout << endl;
-    proofout << "  Final Cost:  " << runtime.bound << endl;
-    proofout << endl;
-
-    if (runtime.reducedCpx) {
-        proofout << "Note that the variables in this cost term are only a sublinear fraction" << endl;
-        proofout << "of the input length n, so the complexity had to be reduced." << endl << endl;
-    }
-
-    proofout << "Obtained the following complexity w.r.t. the length of the input n:" << endl;
-    proofout << "  Complexity class: " << Expression::complexityString(runtime.cpx) << endl;
-    proofout << "  Complexity value: ";
-    {
-        if (runtime.cpx == Expression::ComplexInfty) proofout << "INF" << endl;
-        else if (runtime.cpx == Expression::ComplexNonterm) proofout << "NONTERM" << endl;
-        else if (runtime.cpx == Expression::ComplexExp) proofout << "EXP" << endl;
-        else if (runtime.cpx == Expression::ComplexExpMore) proofout << "EXP" << endl;
-        else if (runtime.cpx == Expression::ComplexNone) proofout << "none" << endl;
-        else proofout << runtime.cpx.val() << endl;
-    }
-
-#ifndef DEBUG_DISABLE_ALL
-    cout << "DEBUG Bound: " << runtime.bound << endl;
-    cout << "DEBUG Complexity value: ";
-    {
-        if (runtime.cpx == Expression::ComplexInfty) cout << "INF" << endl;
-        else if (runtime.cpx == Expression::ComplexNonterm) cout << "NONTERM" << endl;
-        else if (runtime.cpx == Expression::ComplexExp) cout << "EXP" << endl;
-        else if (runtime.cpx == Expression::ComplexExpMore) cout << "EXP" << endl;
-        else if (runtime.cpx == Expression::ComplexNone) proofout << "none" << endl;
-        else cout << runtime.cpx.val() << endl;
-    }
-#endif
-
-    if (dotOutput) {
-        g.printDotText(dotStream,dotStep++,Expression::complexityString(runtime.cpx));
-        dotStream << "}" << endl;
-        dotStream.close();
-    }
-
-    if (printStats) {
-        cout << endl;
-        Stats::print(cout);
+    AnalysisSettings settings;
+    settings.doPreprocessing = doPreprocessing;
+    settings.doPruning = doPruning;
+    settings.checkCosts = checkCosts;
+    settings.printSimplified = printSimplified;
+    settings.recordMemory = printStats || !statusFile.empty();
+    settings.dotStream = dotOutput ? &dotStream : nullptr;
+    settings.checkpointFile = checkpointFile;
+    settings.resumeFile = resumeFile;
+
+    if (portfolio) {
+        return runPortfolio(res,settings,printStats,printTiming);
     }
 
-    if (printTiming) {
-        cout << endl;
-        Timing::print(cout);
-    }
-
-    if (runtime.cpx == Expression::ComplexNonterm) {
-        proofout << endl << "NO" << endl;
-    } else {
-        proofout << endl << "WORST_CASE(";
-        if (runtime.cpx == Expression::ComplexInfty) proofout << "INF";
-        else if (runtime.cpx == Expression::ComplexExp) proofout << "EXP";
-        else if (runtime.cpx == Expression::ComplexExpMore) proofout << "EXP";
-        else if (runtime.cpx == Expression::ComplexNone) proofout << "Omega(0)";
-        else if (runtime.cpx == 0) proofout << "Omega(1)";
-        else proofout << "Omega(n^" << runtime.cpx << ")";
-        proofout << ",?)" << endl;
-    }
-
-    return 0;
+    RuntimeResult runtime;
+    return analyze(res,settings,dotStep,dotOutput ? &dotStream : nullptr,printStats,printTiming,runtime);
 }
 
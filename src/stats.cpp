@@ -17,6 +17,7 @@
 
 #include "stats.h"
 #include "global.h"
+#include "status.h"
 
 #include <map>
 #include <vector>
@@ -28,12 +29,14 @@ typedef map<Stats::StatAction,int> StatData;
 static int step = 0;
 static map<int,StatData> data;
 static vector<string> names = { "Initial" };
+static map<int,Stats::MemoryInfo> memory;
 
 
 void Stats::clear() {
     step = 0;
     data.clear();
     names = { "Initial" };
+    memory.clear();
 }
 
 void Stats::add(StatAction action) {
@@ -44,6 +47,11 @@ void Stats::addStep(const string &name) {
     step++;
     assert(names.size() == step);
     names.push_back(name);
+    Status::setPass(name);
+}
+
+void Stats::setMemory(const MemoryInfo &info) {
+    memory[step] = info;
 }
 
 void Stats::print(ostream &os, bool printZero) {
@@ -54,6 +62,8 @@ void Stats::print(ostream &os, bool printZero) {
 
     int unsat = 0;
     int fail = 0;
+    int memoHits = 0;
+    int memoMisses = 0;
 
     os << " ======== STATS =========" << endl;
     for (int i=0; i <= step; ++i) {
@@ -61,17 +71,52 @@ void Stats::print(ostream &os, bool printZero) {
         printVal(data[i][ContractLinear],"Contract[Linear]");
         printVal(data[i][ContractBranch],"Contract[Branched]");
         printVal(data[i][ContractUnsat], "Contract[Unsat]");
+        printVal(data[i][ContractWitness], "Contract[Witness]");
+        printVal(data[i][ContractSampled], "Contract[Sampled]");
         printVal(data[i][SelfloopRanked],"Loop[Ranked]");
         printVal(data[i][SelfloopNoRank],"Loop[NoRank]");
         printVal(data[i][SelfloopNoUpdate],"Loop[NoUpdate]");
         printVal(data[i][SelfloopInfinite],"Loop[Infinite]");
         printVal(data[i][PruneRemove], "Pruned[Removed]");
+        printVal(data[i][PruneSubsumed], "Pruned[Subsumed]");
+        printVal(data[i][BudgetPruned], "Budget[Pruned]");
+        printVal(data[i][BudgetDeferred], "Budget[Deferred]");
+        printVal(data[i][ExpandMemoHit], "ExpandMemo[Hit]");
+        printVal(data[i][ExpandMemoMiss], "ExpandMemo[Miss]");
+
+        auto mem = memory.find(i);
+        if (mem != memory.end()) {
+            printVal(mem->second.peakRssKb / 1024,"Memory[PeakRSS MB]");
+            printVal(mem->second.z3AllocBytes / (1024*1024),"Memory[Z3 MB]");
+            printVal(mem->second.transitions,"Memory[Transitions]");
+            printVal(mem->second.guardAtoms,"Memory[GuardAtoms]");
+            printVal(mem->second.maxExpressionSize,"Memory[MaxExprSize]");
+        }
 
         unsat += data[i][ContractUnsat];
         fail += data[i][SelfloopNoRank] + data[i][SelfloopNoUpdate];
+        memoHits += data[i][ExpandMemoHit];
+        memoMisses += data[i][ExpandMemoMiss];
     }
 
     if (unsat > 0) os << "NOTE: Contract UNSATs: " << unsat << endl;
     if (fail > 0) os << "CRITICAL: Loop failures: " << fail << endl;
+    if (memoHits + memoMisses > 0) os << "NOTE: Expand memo hit rate: " << (100 * memoHits / (memoHits + memoMisses)) << "%" << endl;
     os << " ======== STATS =========" << endl;
 }
+
+void Stats::printMemoryJson(ostream &os) {
+    os << "[";
+    bool first = true;
+    for (const auto &it : memory) {
+        if (!first) os << ", ";
+        first = false;
+        os << "{\"step\": \"" << names[it.first] << "\""
+           << ", \"peak_rss_kb\": " << it.second.peakRssKb
+           << ", \"z3_alloc_bytes\": " << it.second.z3AllocBytes
+           << ", \"transitions\": " << it.second.transitions
+           << ", \"guard_atoms\": " << it.second.guardAtoms
+           << ", \"max_expr_size\": " << it.second.maxExpressionSize << "}";
+    }
+    os << "]";
+}
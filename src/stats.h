@@ -20,6 +20,7 @@
 
 #include <string>
 #include <ostream>
+#include <cstdint>
 
 
 /**
@@ -27,12 +28,31 @@
  */
 namespace Stats
 {
-    enum StatAction { ContractLinear=0, ContractBranch, ContractUnsat, PruneRemove,
-                      SelfloopRanked, SelfloopNoRank, SelfloopNoUpdate, SelfloopInfinite };
+    enum StatAction { ContractLinear=0, ContractBranch, ContractUnsat, ContractWitness, ContractSampled, PruneRemove, PruneSubsumed,
+                      SelfloopRanked, SelfloopNoRank, SelfloopNoUpdate, SelfloopInfinite,
+                      ExpandMemoHit, ExpandMemoMiss, BudgetPruned, BudgetDeferred };
+    /**
+     * Memory usage at the end of a step, to find out which steps blow up the memory
+     */
+    struct MemoryInfo {
+        long peakRssKb = 0; //peak resident set size of the process so far
+        uint64_t z3AllocBytes = 0; //memory currently allocated by z3
+        int transitions = 0; //live transitions in the graph
+        int guardAtoms = 0; //total number of relations in all guards
+        int maxExpressionSize = 0; //size of the largest guard atom, update or cost (number of nodes)
+    };
+
     void clear();
     void add(StatAction action);
     void addStep(const std::string &name);
+
+    //sets the memory usage of the current step
+    void setMemory(const MemoryInfo &info);
+
     void print(std::ostream &os, bool printZero = false);
+
+    //prints the memory usage of all steps as json array (in a single line)
+    void printMemoryJson(std::ostream &os);
 }
 
 
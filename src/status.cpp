@@ -0,0 +1,156 @@
+/*  This file is part of LoAT.
+ *  Copyright (c) 2015-2016 Matthias Naaf, RWTH Aachen University, Germany
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses>.
+ */
+
+#include "status.h"
+#include "global.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+typedef chrono::steady_clock clk;
+
+static atomic<bool> enabled(false);
+static string statusFile;
+static thread writer;
+
+//protects all fields below
+static mutex statusLock;
+static condition_variable wakeup;
+static bool stopping = false;
+static clk::time_point started;
+static string pass = "Initial";
+static int location = -1;
+static int nodeCount = 0;
+static int transCount = 0;
+static string bestComplexity;
+static const char *tool = nullptr;
+static clk::time_point toolStarted;
+
+
+static void writeStatus(bool finished) {
+    clk::time_point now = clk::now();
+    string tmpFile = statusFile + ".tmp";
+    {
+        ofstream out(tmpFile);
+        if (!out.is_open()) return;
+
+        lock_guard<mutex> guard(statusLock);
+        out << "{\"pid\": " << getpid()
+            << ", \"finished\": " << (finished ? "true" : "false")
+            << ", \"elapsed_ms\": " << chrono::duration_cast<chrono::milliseconds>(now - started).count()
+            << ", \"pass\": \"" << pass << "\""
+            << ", \"location\": " << location
+            << ", \"nodes\": " << nodeCount
+            << ", \"transitions\": " << transCount
+            << ", \"tool\": " << (tool ? string("\"") + tool + "\"" : string("null"))
+            << ", \"tool_ms\": " << (tool ? chrono::duration_cast<chrono::milliseconds>(now - toolStarted).count() : 0)
+            << ", \"best\": " << (bestComplexity.empty() ? string("null") : "\"" + bestComplexity + "\"")
+            << "}" << endl;
+    }
+    rename(tmpFile.c_str(),statusFile.c_str());
+}
+
+
+void Status::start(const string &file) {
+    assert(!enabled);
+    //make sure the thread is stopped on every exit path
+    static bool registered = false;
+    if (!registered) atexit(Status::stop);
+    registered = true;
+
+    statusFile = file;
+    started = clk::now();
+    stopping = false;
+    enabled = true;
+
+    writer = thread([]() {
+        unique_lock<mutex> guard(statusLock);
+        while (!stopping) {
+            guard.unlock();
+            writeStatus(false);
+            guard.lock();
+            wakeup.wait_for(guard,chrono::milliseconds(STATUS_INTERVAL_MS),[]() { return stopping; });
+        }
+    });
+}
+
+
+void Status::stop() {
+    if (!enabled) return;
+    {
+        lock_guard<mutex> guard(statusLock);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    writer.join();
+    enabled = false;
+    writeStatus(true);
+}
+
+
+void Status::setPass(const string &name) {
+    if (!enabled) return;
+    lock_guard<mutex> guard(statusLock);
+    pass = name;
+    location = -1;
+}
+
+
+void Status::setLocation(int node) {
+    if (!enabled) return;
+    lock_guard<mutex> guard(statusLock);
+    location = node;
+}
+
+
+void Status::setGraphSize(int nodes, int transitions) {
+    if (!enabled) return;
+    lock_guard<mutex> guard(statusLock);
+    nodeCount = nodes;
+    transCount = transitions;
+}
+
+
+void Status::setBestComplexity(const string &cpx) {
+    if (!enabled) return;
+    lock_guard<mutex> guard(statusLock);
+    bestComplexity = cpx;
+}
+
+
+void Status::enterTool(const char *name) {
+    if (!enabled) return;
+    lock_guard<mutex> guard(statusLock);
+    tool = name;
+    toolStarted = clk::now();
+}
+
+
+void Status::leaveTool() {
+    if (!enabled) return;
+    lock_guard<mutex> guard(statusLock);
+    tool = nullptr;
+}
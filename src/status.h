@@ -0,0 +1,49 @@
+/*  This file is part of LoAT.
+ *  Copyright (c) 2015-2016 Matthias Naaf, RWTH Aachen University, Germany
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses>.
+ */
+
+#ifndef STATUS_H
+#define STATUS_H
+
+#include <string>
+
+
+/**
+ * Live status of a running analysis, to allow monitoring long runs from the outside.
+ * If enabled, a background thread periodically rewrites the status file (every STATUS_INTERVAL_MS)
+ * with a single json object describing the current pass, location, graph size, the external tool
+ * that is currently running (z3 or purrs) and the best complexity found so far.
+ *
+ * All setters are cheap no-ops if the status file is not enabled.
+ */
+namespace Status {
+    //starts writing the status to the given file (replaced atomically by renaming a temporary file)
+    void start(const std::string &file);
+
+    //writes the final status (marked as finished) and stops the background thread
+    void stop();
+
+    void setPass(const std::string &pass);
+    void setLocation(int node); //-1 if no location is processed
+    void setGraphSize(int nodes, int transitions);
+    void setBestComplexity(const std::string &cpx);
+
+    //called when an external tool is started/done, to report how long the current call takes
+    void enterTool(const char *tool);
+    void leaveTool();
+}
+
+#endif // STATUS_H
@@ -58,6 +58,13 @@ bool Timeout::hard() {
     return now >= timeout_hard;
 }
 
+long Timeout::remainingSoft() {
+    if (!timeout_enable) return -1;
+    timeoutpoint now = chrono::steady_clock::now();
+    if (now >= timeout_soft) return 0;
+    return chrono::duration_cast<chrono::milliseconds>(timeout_soft - now).count();
+}
+
 timeoutpoint Timeout::create(int seconds) {
     timeoutpoint now = chrono::steady_clock::now();
     return now + static_cast<std::chrono::seconds>(seconds);
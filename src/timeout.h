@@ -41,6 +41,9 @@ namespace Timeout {
     bool soft();
     bool hard();
 
+    //returns the remaining time until the soft timeout in ms (0 if over, -1 if no timeout is set)
+    long remainingSoft();
+
     //custom timeouts
     timeoutpoint create(int seconds);
     bool over(const timeoutpoint &point);
@@ -17,6 +17,7 @@
 
 #include "timing.h"
 #include "debug.h"
+#include "status.h"
 
 #include <chrono>
 #include <map>
@@ -38,6 +39,8 @@ void Timing::start(TimingAction action) {
     timepoint now = chrono::high_resolution_clock::now();
     assert(TimingLast.count(action) == 0);
     TimingLast.emplace(action,now);
+    if (action == Z3) Status::enterTool("z3");
+    else if (action == Purrs) Status::enterTool("purrs");
 }
 
 void Timing::done(TimingAction action) {
@@ -46,6 +49,7 @@ void Timing::done(TimingAction action) {
     assert(start != TimingLast.end());
     TimingSum[action] += chrono::duration_cast<chrono::milliseconds>(now - start->second);
     TimingLast.erase(start);
+    if (action == Z3 || action == Purrs) Status::leaveTool();
 }
 
 void Timing::print(ostream &s) {
@@ -18,14 +18,83 @@
 #include "z3toolbox.h"
 
 #include "timing.h"
+#include "timeout.h"
 #include "expression.h"
 #include "flowgraph.h"
 
 #include "debug.h"
 
+#include <algorithm>
+#include <chrono>
+
 using namespace std;
 
 
+#ifdef Z3_UNSAT_CORE_CACHE
+/* ############################## *
+ * ###   Unsat core storage   ### *
+ * ############################## */
+
+//every atom (relation) that occurs in a query is identified by a unique id
+static map<GiNaC::ex,int,GiNaC::ex_is_less> atomIds;
+
+//the known unsat cores as sorted vectors of atom ids, indexed by their smallest atom id
+static map<int,vector<vector<int>>> coresByMinAtom;
+static int coreCount = 0;
+
+
+static void resetCores() {
+    atomIds.clear();
+    coresByMinAtom.clear();
+    coreCount = 0;
+}
+
+
+static vector<int> getAtomIds(const vector<Expression> &list) {
+    //the cores refer to the atom ids, so both are dropped together
+    if (atomIds.size() + list.size() > Z3_UNSAT_CORE_MAX_ATOMS) resetCores();
+
+    vector<int> res;
+    for (const Expression &ex : list) {
+        auto it = atomIds.find(ex);
+        if (it == atomIds.end()) {
+            it = atomIds.emplace(ex,atomIds.size()).first;
+        }
+        res.push_back(it->second);
+    }
+    return res;
+}
+
+
+static bool containsKnownCore(vector<int> atoms) {
+    sort(atoms.begin(),atoms.end());
+    for (int id : atoms) {
+        auto it = coresByMinAtom.find(id);
+        if (it == coresByMinAtom.end()) continue;
+
+        for (const vector<int> &core : it->second) {
+            if (includes(atoms.begin(),atoms.end(),core.begin(),core.end())) return true;
+        }
+    }
+    return false;
+}
+
+
+static void addCore(vector<int> core) {
+    if (core.empty()) return;
+    if (coreCount >= Z3_UNSAT_CORE_CACHE) {
+        //start over (the ids of this core are not valid after the reset)
+        resetCores();
+        return;
+    }
+    sort(core.begin(),core.end());
+    core.erase(unique(core.begin(),core.end()),core.end());
+    coresByMinAtom[core.front()].push_back(std::move(core));
+    coreCount++;
+}
+#endif
+
+
 /* ############################## *
  * ### Context implementation ### *
  * ############################## */
@@ -35,13 +104,16 @@ z3::expr Z3VariableContext::getVariable(string name, VariableType type) {
     //create new variable
     if (it == variables.end()) {
         z3::expr res = (type == Integer) ? int_const(name.c_str()) : real_const(name.c_str());
+        if (type == Integer) hasInt = true; else hasReal = true;
         variables.emplace(name,res);
         basenameCount[name] = 1;
         return res;
     }
     //return existing variable if type matches
-    if (isTypeEqual(it->second,type))
+    if (isTypeEqual(it->second,type)) {
+        if (type == Integer) hasInt = true; else hasReal = true;
         return it->second;
+    }
 
     //name already in use for different type
     return getFreshVariable(name,type);
@@ -79,6 +151,13 @@ bool Z3VariableContext::hasVariableOfAnyType(string name, VariableType &typeOut)
     }
 }
 
+const char* Z3VariableContext::getLogic() const {
+    if (hasInt && hasReal) return nullptr;
+    if (!hasInt && !hasReal) return nullptr;
+    if (nonlinear) return hasInt ? "QF_NIA" : "QF_NRA";
+    return hasInt ? "QF_LIA" : "QF_LRA";
+}
+
 bool Z3VariableContext::isTypeEqual(const z3::expr &expr, VariableType type) const {
     const z3::sort sort = expr.get_sort();
     return ((type == Integer && sort.is_int()) || (type == Real && sort.is_real()));
@@ -86,6 +165,86 @@ bool Z3VariableContext::isTypeEqual(const z3::expr &expr, VariableType type) con
 
 
 
+/* ############################## *
+ * ###   Adaptive  timeouts   ### *
+ * ############################## */
+
+//estimated maximum latency (in ms) of the decided calls per call site
+static map<Z3Toolbox::CallSite,double> siteLatency;
+
+
+//returns 0 if the site has no timeout
+static unsigned getBaseTimeout(Z3Toolbox::CallSite site) {
+    switch (site) {
+        case Z3Toolbox::SiteLimitSmt: return Z3_LIMITSMT_TIMEOUT;
+#ifdef Z3_FARKAS_TIMEOUT
+        case Z3Toolbox::SiteFarkas: return Z3_FARKAS_TIMEOUT;
+#else
+        case Z3Toolbox::SiteFarkas: return 0;
+#endif
+        default: return Z3_CHECK_TIMEOUT;
+    }
+}
+
+
+//returns 0 if the site has no timeout
+static unsigned getTimeout(Z3Toolbox::CallSite site) {
+    unsigned base = getBaseTimeout(site);
+    if (site == Z3Toolbox::SiteDefault || base == 0) return base;
+
+    double timeout = base;
+#ifdef Z3_ADAPTIVE_TIMEOUT
+    auto it = siteLatency.find(site);
+    if (it != siteLatency.end()) {
+        timeout = min(max(Z3_ADAPTIVE_TIMEOUT * it->second, base / 4.0), base * 8.0);
+    }
+#endif
+
+    //never spend too much of the remaining time on a single query
+    long remaining = Timeout::remainingSoft();
+    if (remaining >= 0) {
+        timeout = min(timeout, max(remaining / (double)Z3_ADAPTIVE_BUDGET_FRACTION, 10.0));
+    }
+    return max((unsigned)timeout, 1u);
+}
+
+
+static void reportLatency(Z3Toolbox::CallSite site, z3::check_result res, double elapsed) {
+#ifdef Z3_ADAPTIVE_TIMEOUT
+    if (site == Z3Toolbox::SiteDefault || getBaseTimeout(site) == 0) return;
+
+    //start such that the initial timeout is the base timeout
+    auto it = siteLatency.find(site);
+    if (it == siteLatency.end()) {
+        it = siteLatency.emplace(site,getBaseTimeout(site) / (double)Z3_ADAPTIVE_TIMEOUT).first;
+    }
+
+    //only decided calls tell us how long the site needs, as unknown might also be due to the theory (e.g. nonlinear)
+    if (res != z3::unknown) {
+        it->second = max(elapsed, Z3_ADAPTIVE_LATENCY_DECAY * it->second);
+    }
+#endif
+}
+
+
+z3::check_result Z3Toolbox::check(Z3Solver &solver, CallSite site, const z3::expr_vector *assumptions) {
+    unsigned timeout = getTimeout(site);
+    if (timeout > 0) {
+        z3::params params(solver.ctx());
+        params.set(":timeout", timeout);
+        solver.set(params);
+    }
+
+    auto start = chrono::steady_clock::now();
+    z3::check_result res = (assumptions) ? solver.check(*assumptions) : solver.check();
+    double elapsed = chrono::duration<double,milli>(chrono::steady_clock::now() - start).count();
+
+    reportLatency(site,res,elapsed);
+    return res;
+}
+
+
+
 /* ############################## *
  * ###   Z3Toolbox  methods   ### *
  * ############################## */
@@ -115,13 +274,28 @@ Expression Z3Toolbox::getRealFromModel(const z3::model &model, const z3::expr &s
 }
 
 
-z3::check_result Z3Toolbox::checkExpressionsSAT(const std::vector<Expression> &list) {
+void Z3Toolbox::clearUnsatCores() {
+#ifdef Z3_UNSAT_CORE_CACHE
+    resetCores();
+#endif
+}
+
+
+z3::check_result Z3Toolbox::checkExpressionsSAT(const std::vector<Expression> &list, CallSite site) {
     Z3VariableContext context;
-    return checkExpressionsSAT(list,context);
+    return checkExpressionsSAT(list,context,nullptr,site);
 }
 
 
-z3::check_result Z3Toolbox::checkExpressionsSAT(const vector<Expression> &list, Z3VariableContext &context, z3::model *model) {
+z3::check_result Z3Toolbox::checkExpressionsSAT(const vector<Expression> &list, Z3VariableContext &context, z3::model *model, CallSite site) {
+#ifdef Z3_UNSAT_CORE_CACHE
+    vector<int> atoms = getAtomIds(list);
+    if (containsKnownCore(atoms)) {
+        debugZ3("<cached core>",z3::unsat,"checkExprSAT");
+        return z3::unsat;
+    }
+#endif
+
     vector<z3::expr> exprvec;
     for (const Expression &expr : list) {
         exprvec.push_back(expr.toZ3(context));
@@ -129,19 +303,57 @@ z3::check_result Z3Toolbox::checkExpressionsSAT(const vector<Expression> &list,
     z3::expr target = concatExpressions(context,exprvec,ConcatAnd);
 
     Z3Solver solver(context);
-    z3::params params(context);
-    params.set(":timeout", Z3_CHECK_TIMEOUT);
-    solver.set(params);
     solver.add(target);
-    z3::check_result z3res = solver.check();
+    z3::check_result z3res = check(solver,site);
     debugZ3(solver,z3res,"checkExprSAT");
 
+#ifdef Z3_UNSAT_CORE_CACHE
+    //only checks without assumptions use the logic-specific tactics (e.g. for nonlinear arithmetic),
+    //so the unsat core is computed by a second check, where every atom is tracked by an assumption literal
+    if (z3res == z3::unsat) {
+        z3::expr_vector assumptions(context);
+        Z3Solver coreSolver(context);
+        for (int i=0; i < list.size(); ++i) {
+            z3::expr lit = context.bool_const(("__core_" + to_string(atoms[i])).c_str());
+            coreSolver.add(z3::implies(lit,exprvec[i]));
+            assumptions.push_back(lit);
+        }
+
+        if (check(coreSolver,site,&assumptions) == z3::unsat) {
+            z3::expr_vector core = coreSolver.unsat_core();
+            vector<int> coreAtoms;
+            for (unsigned i=0; i < core.size(); ++i) {
+                for (int j=0; j < assumptions.size(); ++j) {
+                    if (z3::eq(core[i],assumptions[j])) coreAtoms.push_back(atoms[j]);
+                }
+            }
+            addCore(std::move(coreAtoms));
+        }
+    }
+#endif
+
     if (z3res == z3::sat && model) *model = solver.get_model();
     return z3res;
 }
 
 
-z3::check_result Z3Toolbox::checkExpressionsSATapproximate(const std::vector<Expression> &list) {
+z3::check_result Z3Toolbox::checkExpressionsSATwitness(const vector<Expression> &list, GiNaC::exmap &witness, CallSite site) {
+    Z3VariableContext context;
+    z3::model model(context,Z3_model());
+    z3::check_result z3res = checkExpressionsSAT(list,context,&model,site);
+
+    if (z3res == z3::sat) {
+        ExprSymbolSet symbols;
+        for (const Expression &ex : list) ex.collectVariables(symbols);
+        for (const ExprSymbol &sym : symbols) {
+            witness[sym] = getRealFromModel(model,Expression::ginacToZ3(sym,context));
+        }
+    }
+    return z3res;
+}
+
+
+z3::check_result Z3Toolbox::checkExpressionsSATapproximate(const std::vector<Expression> &list, CallSite site) {
     Z3VariableContext context;
     vector<z3::expr> exprvec;
     for (const Expression &expr : list) {
@@ -150,18 +362,15 @@ z3::check_result Z3Toolbox::checkExpressionsSATapproximate(const std::vector<Exp
     z3::expr target = concatExpressions(context,exprvec,ConcatAnd);
 
     Z3Solver solver(context);
-    z3::params params(context);
-    params.set(":timeout", Z3_CHECK_TIMEOUT);
-    solver.set(params);
     solver.add(target);
-    z3::check_result z3res = solver.check();
+    z3::check_result z3res = check(solver,site);
     debugZ3(solver,z3res,"checkExprSATapprox");
     return z3res;
 }
 
 
 
-bool Z3Toolbox::checkTautologicImplication(const vector<Expression> &lhs, const Expression &rhs) {
+bool Z3Toolbox::checkTautologicImplication(const vector<Expression> &lhs, const Expression &rhs, CallSite site) {
     using namespace z3; //for z3::implies, due to a z3 bug
     Z3VariableContext context;
 
@@ -171,9 +380,6 @@ bool Z3Toolbox::checkTautologicImplication(const vector<Expression> &lhs, const
     for (const Expression &ex : lhs) lhsList.push_back(ex.toZ3(context));
 
     Z3Solver solver(context);
-    z3::params params(context);
-    params.set(":timeout", Z3_CHECK_TIMEOUT);
-    solver.set(params);
     solver.add(!rhsExpr && concatExpressions(context,lhsList,ConcatAnd));
-    return solver.check() == z3::unsat; //must be unsat to prove the original implication
+    return check(solver,site) == z3::unsat; //must be unsat to prove the original implication
 }
@@ -22,6 +22,7 @@
 #include "timing.h"
 
 #include <z3++.h>
+#include <ginac/ginac.h>
 #include <vector>
 #include <map>
 
@@ -64,27 +65,59 @@ public:
      */
     bool hasVariableOfAnyType(std::string name, VariableType &typeOut) const;
 
+    /**
+     * Classification of the expressions translated in this context (used to choose a specialized solver).
+     * Variables are recorded by getVariable, nonlinear terms and rational constants by Expression::ginacToZ3.
+     */
+    void markNonlinear() { nonlinear = true; }
+    void markReal() { hasReal = true; }
+
+    /**
+     * Returns the smt logic of all expressions translated so far (e.g. "QF_LIA"),
+     * or nullptr if the default solver should be used (e.g. for mixed integer/real arithmetic)
+     */
+    const char* getLogic() const;
+
 private:
     bool isTypeEqual(const z3::expr &expr, VariableType type) const;
 
 private:
     std::map<std::string,z3::expr> variables;
     std::map<std::string,int> basenameCount;
+    bool hasInt = false;
+    bool hasReal = false;
+    bool nonlinear = false;
 };
 
 
 /**
- * Wrapper around z3 solver to gain timing information
+ * Wrapper around z3 solver to gain timing information.
+ * The solver is specialized for the logic of the expressions translated in the context so far (see Z3_LOGIC_SPECIFIC_SOLVERS)
  */
 class Z3Solver : public z3::solver {
 public:
-    Z3Solver(Z3VariableContext &context) : z3::solver(context) {}
+    Z3Solver(Z3VariableContext &context) : z3::solver(create(context)) {}
     inline z3::check_result check() {
         Timing::start(Timing::Z3);
         z3::check_result res = z3::solver::check();
         Timing::done(Timing::Z3);
         return res;
     }
+    inline z3::check_result check(const z3::expr_vector &assumptions) {
+        Timing::start(Timing::Z3);
+        z3::check_result res = z3::solver::check(assumptions);
+        Timing::done(Timing::Z3);
+        return res;
+    }
+
+private:
+    static z3::solver create(Z3VariableContext &context) {
+#ifdef Z3_LOGIC_SPECIFIC_SOLVERS
+        const char *logic = context.getLogic();
+        if (logic) return z3::solver(context,logic);
+#endif
+        return z3::solver(context);
+    }
 };
 
 
@@ -94,6 +127,19 @@ public:
 namespace Z3Toolbox {
     enum ConcatOperator { ConcatAnd, ConcatOr };
 
+    /**
+     * The call sites that have their own (adaptive) timeout, see Z3_ADAPTIVE_TIMEOUT.
+     * SiteDefault always uses the fixed Z3_CHECK_TIMEOUT.
+     */
+    enum CallSite { SiteDefault=0, SiteChaining, SiteWeakerGuards, SiteRemoveCost, SiteInstantiate, SiteFarkas, SiteLimitSmt, SiteSubsumption };
+
+    /**
+     * Checks the given solver with the current timeout of the given call site
+     * (and updates the timeout of this site based on the observed latency)
+     * @param assumptions if given, the solver is checked under these assumptions
+     */
+    z3::check_result check(Z3Solver &solver, CallSite site, const z3::expr_vector *assumptions = nullptr);
+
     /**
      * Tiny helper to create a list of and- or or-concated expressions
      * @param list expressions to concat
@@ -107,28 +153,41 @@ namespace Z3Toolbox {
      */
     Expression getRealFromModel(const z3::model &model, const z3::expr &symbol);
 
+    /**
+     * Drops all recorded unsat cores and the atoms they refer to (e.g. before analyzing another problem)
+     */
+    void clearUnsatCores();
+
     /**
      * Returns the z3 result (sat/unsat/unknown) for the check if all expressions are satisfiable
      */
-    z3::check_result checkExpressionsSAT(const std::vector<Expression> &list);
+    z3::check_result checkExpressionsSAT(const std::vector<Expression> &list, CallSite site = SiteDefault);
 
     /**
      * Extended version of checkExpressionsSAT that works on a given context and can be used to obtain the model
      * @note the model must have been created with the given context
+     * @note if Z3_UNSAT_CORE_CACHE is defined, unsat cores are recorded and used to detect unsat queries without calling z3
+     */
+    z3::check_result checkExpressionsSAT(const std::vector<Expression> &list, Z3VariableContext &context, z3::model *model = nullptr,
+                                         CallSite site = SiteDefault);
+
+    /**
+     * Like checkExpressionsSAT, but also returns the model (if sat) as substitution of all symbols in list by integers
+     * @note the witness is only a candidate, it should be checked with GuardToolbox::isSatisfiedBy before it is used
      */
-    z3::check_result checkExpressionsSAT(const std::vector<Expression> &list, Z3VariableContext &context, z3::model *model = nullptr);
+    z3::check_result checkExpressionsSATwitness(const std::vector<Expression> &list, GiNaC::exmap &witness, CallSite site = SiteDefault);
 
     /**
      * Returns an approximation of the z3 result (sat/unsat/unknown) for the check if all expressions are satisfiable
      * @note currently, integer are treated as reals to reduce unknowns
      * @note using this function is *NOT* sound (obviously)
      */
-    z3::check_result checkExpressionsSATapproximate(const std::vector<Expression> &list);
+    z3::check_result checkExpressionsSATapproximate(const std::vector<Expression> &list, CallSite site = SiteDefault);
 
     /**
      * Returns true iff the implication "AND(lhs) -> rhs" is a (z3-provable) tautology in all occurring symbols
      */
-    bool checkTautologicImplication(const std::vector<Expression> &lhs, const Expression &rhs);
+    bool checkTautologicImplication(const std::vector<Expression> &lhs, const Expression &rhs, CallSite site = SiteDefault);
 }
 
 #endif // Z3TOOLBOX_H